@@ -0,0 +1,288 @@
+#define BOOST_GEOMETRY_NO_ROBUSTNESS
+#include <iostream>
+#include "correct.hpp"
+
+#include <boost/format.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+
+#include "data/CLC2006_180927.wkt.cpp"
+
+namespace bg = boost::geometry;
+typedef bg::model::d2::point_xy<double> point;
+typedef bg::model::ring<point> ring;
+typedef bg::model::polygon<point> polygon;
+typedef bg::model::multi_polygon<polygon> multi_polygon;
+
+// Count the allocations of the benchmarked code
+static std::atomic<std::size_t> allocations(0);
+
+void *operator new(std::size_t size)
+{
+	++allocations;
+	if(void *p = std::malloc(size ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+static std::string filter;
+static std::chrono::duration<double> min_time(0.5);
+
+// Run the function repeatedly for at least min_time. Time and allocations are reported
+// per run and time also per vertex of the input.
+template<typename function_t>
+void bench(std::string const &name, std::size_t vertices, function_t const &function)
+{
+	if(name.find(filter) == std::string::npos)
+		return;
+
+	// Warm up, buffers reused between runs are allocated here
+	function();
+
+	std::size_t runs = 0;
+	std::size_t start_allocations = allocations;
+	auto start = std::chrono::steady_clock::now();
+	std::chrono::duration<double> elapsed(0);
+	do {
+		function();
+		++runs;
+		elapsed = std::chrono::steady_clock::now() - start;
+	} while(elapsed < min_time);
+
+	double ns = elapsed.count() * 1E9 / runs;
+	double allocs = double(allocations - start_allocations) / runs;
+	std::cout << boost::format("%-48s %8d %14.0f %12.1f %12.1f") % name % runs % ns % (ns / std::max<std::size_t>(vertices, 1)) % allocs << std::endl;
+}
+
+// Ring with random points in the unit square, almost every segment intersects others
+ring random_ring(std::size_t vertices, unsigned int seed)
+{
+	std::mt19937 engine(seed);
+	std::uniform_real_distribution<double> distribution(0.0, 1.0);
+
+	ring result;
+	for(std::size_t i = 0; i < vertices; ++i)
+		result.push_back(point(distribution(engine), distribution(engine)));
+	result.push_back(result.front());
+	return result;
+}
+
+// Star polygon {vertices/step}, every vertex adds step - 1 intersections
+ring star_ring(std::size_t vertices, std::size_t step)
+{
+	double const pi = boost::math::constants::pi<double>();
+
+	ring result;
+	for(std::size_t i = 0; i <= vertices; ++i) {
+		double angle = 2 * pi * double((i * step) % vertices) / double(vertices);
+		result.push_back(point(std::cos(angle), std::sin(angle)));
+	}
+	return result;
+}
+
+// Square with a grid of inners, neighbouring inners overlap
+polygon grid_polygon(std::size_t inners)
+{
+	std::size_t columns = std::max<std::size_t>(1, std::size_t(std::ceil(std::sqrt(double(inners)))));
+	double cell = 1.0 / double(columns + 1);
+
+	polygon result;
+	bg::read_wkt("POLYGON((0 0, 0 1, 1 1, 1 0, 0 0))", result);
+	for(std::size_t i = 0; i < inners; ++i) {
+		double x = cell * double(i % columns + 1) - 0.1 * cell;
+		double y = cell * double(i / columns + 1) - 0.1 * cell;
+		double size = 0.8 * cell;
+		result.inners().push_back({ point(x, y), point(x + size, y), point(x + size, y + size), point(x, y + size), point(x, y) });
+	}
+	return result;
+}
+
+std::size_t vertex_count(polygon const &poly)
+{
+	return bg::num_points(poly);
+}
+
+// Stages of the correction of a single ring
+void bench_ring_stages(std::string const &name, ring const &input)
+{
+	typedef geometry::impl::correct_workspace<point, ring> workspace_t;
+	std::size_t vertices = input.size();
+
+	bench(name + " correct_compact", vertices, [&]() {
+		ring copy = input;
+		geometry::impl::correct_compact(copy, true, false);
+	});
+
+	ring prepared = input;
+	geometry::impl::correct_compact(prepared, true, false);
+	geometry::impl::correct_orientation(prepared, bg::clockwise);
+
+	workspace_t workspace;
+	bench(name + " find_intersections sweep", vertices, [&]() {
+		workspace.graph.clear();
+		geometry::impl::dissolve_find_intersections(prepared, workspace.graph,
+			geometry::impl::sweep_intersections<decltype(workspace.segments)>{ workspace.segments, workspace.active });
+	});
+
+	bench(name + " find_intersections self_turns", vertices, [&]() {
+		workspace.graph.clear();
+		geometry::impl::dissolve_find_intersections(prepared, workspace.graph,
+			geometry::impl::self_turns_intersections<decltype(workspace.turns)>{ workspace.turns });
+	});
+
+	bench(name + " find_intersections sections", vertices, [&]() {
+		workspace.graph.clear();
+		geometry::impl::dissolve_find_intersections(prepared, workspace.graph,
+			geometry::impl::section_intersections<decltype(workspace.sections)>{ workspace.sections });
+	});
+
+	workspace.graph.clear();
+	geometry::impl::dissolve_find_intersections(prepared, workspace.graph,
+		geometry::impl::sweep_intersections<decltype(workspace.segments)>{ workspace.segments, workspace.active });
+
+	bench(name + " generate_rings", vertices, [&]() {
+		geometry::impl::dissolve_generate_rings<point, ring>(workspace.graph, bg::clockwise);
+	});
+
+	// Traced rings as input of the fill functors, the copy of the input is included in the time
+	std::vector<std::pair<multi_polygon, double>> traced;
+	for(auto &traced_ring: geometry::impl::dissolve_generate_rings<point, ring>(workspace.graph, bg::clockwise)) {
+		polygon poly;
+		poly.outer() = std::move(traced_ring.first);
+		traced.emplace_back(multi_polygon{ std::move(poly) }, traced_ring.second);
+	}
+
+	bench(name + " fill_non_zero_winding direct", vertices, [&]() {
+		auto copy = traced;
+		geometry::impl::fill_non_zero_winding_direct<point, polygon, multi_polygon>()(copy);
+	});
+
+	bench(name + " fill_non_zero_winding overlay", vertices, [&]() {
+		auto copy = traced;
+		geometry::impl::fill_non_zero_winding<point, polygon, multi_polygon>()(copy);
+	});
+
+	bench(name + " fill_odd_even", vertices, [&]() {
+		auto copy = traced;
+		geometry::impl::fill_odd_even<point, polygon, multi_polygon>()(copy);
+	});
+}
+
+// End-to-end correction of a polygon
+void bench_polygon(std::string const &name, polygon const &input)
+{
+	std::size_t vertices = vertex_count(input);
+
+	bench(name + " correct", vertices, [&]() {
+		multi_polygon result;
+		geometry::correct(input, result);
+	});
+
+	bench(name + " correct_odd_even", vertices, [&]() {
+		multi_polygon result;
+		geometry::correct_odd_even(input, result);
+	});
+
+	geometry::corrector<point> corrector;
+	bench(name + " corrector", vertices, [&]() {
+		multi_polygon result;
+		corrector.correct(input, result);
+	});
+}
+
+// Combine the corrected parts of the inners
+void bench_combine(std::string const &name, polygon const &input)
+{
+	std::vector<multi_polygon> parts;
+	std::size_t vertices = 0;
+	for(auto const &inner: input.inners()) {
+		polygon poly;
+		poly.outer() = inner;
+		bg::correct(poly);
+		parts.push_back(multi_polygon{ poly });
+		vertices += inner.size();
+	}
+
+	bench(name + " result_combine_multiple", vertices, [&]() {
+		multi_polygon result;
+		for(auto part: parts)
+			geometry::impl::result_combine_multiple(result, part);
+	});
+
+	bench(name + " combine_reduce", vertices, [&]() {
+		auto copy = parts;
+		multi_polygon result;
+		geometry::impl::combine_reduce(copy, result, geometry::impl::result_combine_multiple<multi_polygon, multi_polygon>);
+	});
+}
+
+int main(int argc, char *argv[])
+{
+	// bench [filter] [seconds per benchmark]
+	if(argc > 1)
+		filter = argv[1];
+	if(argc > 2)
+		min_time = std::chrono::duration<double>(std::atof(argv[2]));
+
+	std::cout << boost::format("%-48s %8s %14s %12s %12s") % "benchmark" % "runs" % "ns/run" % "ns/vertex" % "allocs/run" << std::endl;
+
+	// Vertex count
+	for(std::size_t vertices: { 10, 100, 300 }) {
+		std::string name = "random/" + std::to_string(vertices);
+		ring input = random_ring(vertices, 42);
+		bench_ring_stages(name, input);
+
+		polygon poly;
+		poly.outer() = input;
+		bench_polygon(name, poly);
+	}
+
+	// Intersection density, intersections per vertex is step - 1
+	for(std::size_t step: { 2, 5, 17 }) {
+		std::string name = "star/1001/" + std::to_string(step);
+		ring input = star_ring(1001, step);
+		bench_ring_stages(name, input);
+
+		polygon poly;
+		poly.outer() = input;
+		bench_polygon(name, poly);
+	}
+
+	// Number of inners
+	for(std::size_t inners: { 4, 64, 256 }) {
+		std::string name = "inners/" + std::to_string(inners);
+		polygon poly = grid_polygon(inners);
+		bench_combine(name, poly);
+		bench_polygon(name, poly);
+	}
+
+	// https://github.com/hugoledoux/BIGpolygons
+	{
+		polygon poly;
+		bg::read_wkt(wkt_CLC2006_180927, poly);
+		// Reading the input as text or binary
+		std::vector<unsigned char> wkb;
+		geometry::write_wkb(poly, wkb);
+		bench("CLC2006 read_wkt", vertex_count(poly), [&]() {
+			polygon read;
+			bg::read_wkt(wkt_CLC2006_180927, read);
+		});
+		bench("CLC2006 read_wkb", vertex_count(poly), [&]() {
+			polygon read;
+			geometry::read_wkb(wkb.data(), wkb.size(), read);
+		});
+
+		bench_ring_stages("CLC2006 outer", poly.outer());
+		bench_combine("CLC2006", poly);
+		bench_polygon("CLC2006", poly);
+	}
+}
@@ -30,6 +30,18 @@ void map(std::string const& name, Mp const& mp, Mp const& result)
   mapper.map(result, "fill-opacity:0.6;fill:rgb(0,0,255);stroke:rgb(0,0,128);" "stroke-width:2");
 }
 
+template <typename Mp>
+void correct_cascaded(Mp const& mp, Mp& result, double remove_spike_threshold)
+{
+  using polygon = typename boost::range_value<Mp>::type;
+  using point = typename boost::geometry::point_type<Mp>::type;
+
+  geometry::impl::correct(mp, result, remove_spike_threshold,
+    geometry::impl::fill_non_zero_winding<point, polygon, Mp>(),
+    geometry::impl::result_combine_cascaded<Mp, Mp>,
+    boost::geometry::difference<Mp, Mp, Mp>);
+}
+
 template <typename Mp>
 void measure_performance(std::string const& name, Mp const& mp, char option, int count)
 {
@@ -41,9 +53,9 @@ void measure_performance(std::string const& name, Mp const& mp, char option, int
     Mp result;
     switch(option)
     {
- //     case 'd' : boost::geometry::dissolve(mp, result); break;
       case 'c' : geometry::correct(mp, result, remove_spike_threshold); break;
       case 'o' : geometry::correct_odd_even(mp, result, remove_spike_threshold); break;
+      case 'u' : correct_cascaded(mp, result, remove_spike_threshold); break;
     }
   }
   auto const end = std::chrono::steady_clock::now();
@@ -57,15 +69,23 @@ void compare_fix_methods(std::string const& name, std::string const& wkt, int co
   using polygon = boost::geometry::model::polygon<point>;
   using multi_polygon = boost::geometry::model::multi_polygon<polygon>;
 
-  multi_polygon mp, dissolved, corrected, oddeven;
+  multi_polygon mp, dissolved, corrected, oddeven, cascaded;
 
-  boost::geometry::read_wkt(wkt, mp);
+  if (wkt.rfind("POLYGON", 0) == 0)
+  {
+    polygon poly;
+    boost::geometry::read_wkt(wkt, poly);
+    mp.push_back(poly);
+  }
+  else
+    boost::geometry::read_wkt(wkt, mp);
 
  // boost::geometry::dissolve(mp, dissolved);
 
   double const remove_spike_threshold = 1E-12;
   geometry::correct(mp, corrected, remove_spike_threshold);
   geometry::correct_odd_even(mp, oddeven, remove_spike_threshold);
+  correct_cascaded(mp, cascaded, remove_spike_threshold);
 
   auto valid_str = [](bool v) { return v ? "valid" : "invalid"; };
   std::cout << name << " areas " << boost::geometry::area(mp)
@@ -78,6 +98,9 @@ void compare_fix_methods(std::string const& name, std::string const& wkt, int co
 
             << " o " << boost::geometry::area(oddeven)
             << " " << valid_str(boost::geometry::is_valid(oddeven))
+
+            << " u " << boost::geometry::area(cascaded)
+            << " " << valid_str(boost::geometry::is_valid(cascaded))
             << std::endl;
 
  //  map(name + "_d", mp, dissolved);
@@ -86,9 +109,9 @@ void compare_fix_methods(std::string const& name, std::string const& wkt, int co
 
    if (count > 0)
    {
-     measure_performance(name, mp, 'd', count);
      measure_performance(name, mp, 'c', count);
      measure_performance(name, mp, 'o', count);
+     measure_performance(name, mp, 'u', count);
    }
    std::cout << std::endl;
 }
@@ -11,6 +11,28 @@
  */
 
 #include <vector>
+#include <cmath>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <list>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
 #include <boost/geometry.hpp>
 #include <boost/geometry/geometries/point_xy.hpp>
 #include <boost/geometry/geometries/polygon.hpp>
@@ -22,511 +44,4217 @@
 #include <boost/geometry/policies/robustness/get_rescale_policy.hpp>
 #include <boost/geometry/strategies/strategies.hpp>
 
-namespace geometry {
+// The kernels of the sweep are compiled for AVX2 and for the default target, the version is 
+// selected at runtime for the CPU. GCC only vectorizes these loops at -O2 with the dynamic cost 
+// model. Define BOOST_GEOMETRY_CORRECT_NO_TARGET_CLONES to disable.
+#if defined(__x86_64__) && defined(__has_attribute) && !defined(BOOST_GEOMETRY_CORRECT_NO_TARGET_CLONES)
+#if __has_attribute(target_clones) && defined(__clang__)
+#define BOOST_GEOMETRY_CORRECT_TARGET_CLONES __attribute__((target_clones("avx2", "default")))
+#elif __has_attribute(target_clones)
+#define BOOST_GEOMETRY_CORRECT_TARGET_CLONES __attribute__((target_clones("avx2", "default"), optimize("vect-cost-model=dynamic")))
+#endif
+#endif
+#ifndef BOOST_GEOMETRY_CORRECT_TARGET_CLONES
+#define BOOST_GEOMETRY_CORRECT_TARGET_CLONES
+#endif
 
-namespace impl {
+namespace geometry {
 
-template<typename C, typename T>
-static inline void result_combine(C &result, T &&new_element)
+// Pool of worker threads for the parallel correct overloads
+class thread_pool
 {
-    result.push_back(new_element);
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>> tasks;
+	std::mutex mutex;
+	std::condition_variable condition;
+	bool stopping = false;
 
-   	for(std::size_t i = 0; i < result.size() - 1; ) {
-        if(!boost::geometry::intersects(result[i], result.back())) {
-            ++i;
-            continue;
-        }
+public:
+	explicit thread_pool(std::size_t thread_count = std::thread::hardware_concurrency())
+	{
+		for(std::size_t i = 0; i < thread_count; ++i) {
+			workers.emplace_back([this]() {
+				for(;;) {
+					std::function<void()> task;
+					{
+						std::unique_lock<std::mutex> lock(mutex);
+						condition.wait(lock, [this]() { return stopping || !tasks.empty(); });
+						if(tasks.empty())
+							return;
+
+						task = std::move(tasks.front());
+						tasks.pop_front();
+					}
+					task();
+				}
+			});
+		}
+	}
 
-        std::vector<T> union_result;
-        boost::geometry::union_(result[i], result.back(), union_result);
+	thread_pool(thread_pool const &) = delete;
+	thread_pool &operator=(thread_pool const &) = delete;
 
-        if(union_result.size() != 1) {
-			++i;
-			continue;
+	~thread_pool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
 		}
+		condition.notify_all();
+		for(auto &worker: workers)
+			worker.join();
+	}
 
-       	result.back() = std::move(union_result[0]);
-       	result.erase(result.begin() + i);
-    } 
-}
+	std::size_t size() const 
+	{
+		return workers.size();
+	}
 
-template<typename C, typename T>
-static inline void result_combine_multiple(C &result, T &new_elements)
-{
-	for(auto &element: new_elements)
-		result_combine(result, std::move(element));
-}
+	void submit(std::function<void()> task)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			tasks.push_back(std::move(task));
+		}
+		condition.notify_one();
+	}
 
-struct pseudo_vertice_key
-{
-    std::size_t index_1;
-    double scale;
-    std::size_t index_2;
-    bool reroute;
-    
-    pseudo_vertice_key(std::size_t index_1 = 0, std::size_t index_2 = 0, double scale = 0.0, bool reroute = false)
-        : index_1(index_1), scale(scale), index_2(index_2), reroute(reroute)
-    { } 
+	// Call f(i) for every i in [0, count). The calling thread takes part in the work 
+	// and only waits for items which are already being processed, so this can also 
+	// be called from a task running on the pool.
+	template<typename F>
+	void parallel_for(std::size_t count, F const &f)
+	{
+		struct state_t
+		{
+			std::atomic<std::size_t> next { 0 };
+			std::size_t done = 0;
+			std::exception_ptr error;
+			std::mutex mutex;
+			std::condition_variable condition;
+		};
+
+		auto state = std::make_shared<state_t>();
+		auto work = [state, count, &f]() {
+			for(std::size_t i = state->next++; i < count; i = state->next++) {
+				std::exception_ptr error;
+				try {
+					f(i);
+				} catch(...) {
+					error = std::current_exception();
+				}
+
+				std::lock_guard<std::mutex> lock(state->mutex);
+				if(error && !state->error)
+					state->error = error;
+				if(++state->done == count)
+					state->condition.notify_all();
+			}
+		};
+
+		std::size_t helpers = std::min(workers.size(), count > 0 ? count - 1 : 0);
+		for(std::size_t i = 0; i < helpers; ++i)
+			submit(work);
+
+		work();
+
+		std::unique_lock<std::mutex> lock(state->mutex);
+		state->condition.wait(lock, [&state, count]() { return state->done == count; });
+		if(state->error)
+			std::rethrow_exception(state->error);
+	}
 };
 
-struct compare_pseudo_vertice_key
+// Method used to find the self intersections of a ring
+enum class intersection_method
 {
-    bool operator()(pseudo_vertice_key const &a, pseudo_vertice_key const &b) const {
-        if(a.index_1 < b.index_1) return true;
-        if(a.index_1 > b.index_1) return false;
-        if(a.scale < b.scale) return true;
-        if(a.scale > b.scale) return false;
-        if(a.index_2 > b.index_2) return true;
-        if(a.index_2 < b.index_2) return false;
-        if(a.reroute && !b.reroute) return true;
-        if(!a.reroute && b.reroute) return false;
-		return false;
-    }
+	self_turns,		// boost::geometry::self_turns
+	sweep,			// Sweep over the segments sorted on x
+	sections		// Pairs of monotonic sections found in a packed rtree
 };
 
-template<typename point_t = boost::geometry::model::d2::point_xy<double>>
-struct pseudo_vertice
+// Method used to fill the rings traced from a polygon with the non-zero winding rule
+enum class fill_method
 {
-    point_t p;
-    pseudo_vertice_key link;
-    
-    pseudo_vertice(point_t p, pseudo_vertice_key link = pseudo_vertice_key())   
-        : p(p), link(link)
-    { }        
+	direct,			// Winding number of every ring, output assembled from the ring edges
+	overlay			// Union of the filled rings minus the union of the unfilled rings
 };
 
-struct assign_policy    {
-	static bool const include_no_turn = true;
-	static bool const include_degenerate = true;
-	static bool const include_opposite = true;
-	static bool const include_start_turn = true;
+// Stages of the correction, for which the time is recorded in correct_statistics
+enum class correct_stage
+{
+	compact,		// Remove invalid, repeated and collinear points, close and orient the rings
+	intersections,	// Find the self intersections of the rings
+	trace,			// Trace the rings through the pseudo-vertices
+	fill,			// Fill the traced rings
+	combine,		// Combine and difference of the corrected rings and polygons
+	count
 };
 
-template<
-	typename point_t = boost::geometry::model::d2::point_xy<double>, 
-	typename ring_t = boost::geometry::model::ring<point_t>
-	>
-static inline void dissolve_find_intersections(
-			ring_t const &ring,
-			std::map<pseudo_vertice_key, pseudo_vertice<point_t>, compare_pseudo_vertice_key> &pseudo_vertices,
-    		std::set<pseudo_vertice_key, compare_pseudo_vertice_key> &start_keys)
+// Statistics of one or more corrections
+struct correct_statistics
 {
-	if(ring.empty()) return;
-   
-    for(std::size_t i = 0; i < ring.size(); ++i) {
-        pseudo_vertices.emplace(pseudo_vertice_key(i, i, 0.0), ring[i]);       
-	}
-
-	// Detect intersections and generate pseudo-vertices
-	boost::geometry::strategies::cartesian<> strategy;
-    typedef boost::geometry::detail::no_rescale_policy rescale_policy_type;
-    typedef boost::geometry::detail::overlay::turn_info
-        <
-            point_t
-        > turn_info;
-
-    std::vector<turn_info> turns;
+	std::array<std::chrono::steady_clock::duration, std::size_t(correct_stage::count)> time{};
 
-    rescale_policy_type rescale_policy;
+	std::size_t rings = 0;					// Rings corrected
+	std::size_t turns = 0;					// Self intersections found
+	std::size_t pseudo_vertices = 0;		// Vertices in the pseudo-vertex graphs
+	std::size_t rings_traced = 0;			// Rings traced from the pseudo-vertex graphs
+	std::size_t rings_dropped = 0;			// Traced rings with an area below remove_spike_min_area
+	std::size_t overlay_calls = 0;			// Calls of the combine and difference operations
 
-    boost::geometry::detail::self_get_turn_points::no_interrupt_policy policy;
-    boost::geometry::self_turns
-        <
-			assign_policy
-        >(ring, strategy, rescale_policy, turns, policy);
+	// Peak sizes over all rings
+	std::size_t max_ring_size = 0;
+	std::size_t max_pseudo_vertices = 0;
+	std::size_t max_rings_traced = 0;
 
-	for(auto const &turn: turns) {
-		auto p = turn.point;
-		auto i = std::min(turn.operations[0].seg_id.segment_index, turn.operations[1].seg_id.segment_index);
-		auto j = std::max(turn.operations[0].seg_id.segment_index, turn.operations[1].seg_id.segment_index);
+	void add_time(correct_stage stage, std::chrono::steady_clock::duration duration)
+	{
+		time[std::size_t(stage)] += duration;
+	}
 
-		double offset_1 = boost::geometry::comparable_distance(p, ring[i]);
-		double offset_2 = boost::geometry::comparable_distance(p, ring[j]);
+	void add_ring(std::size_t ring_size, std::size_t ring_turns, std::size_t ring_pseudo_vertices, std::size_t traced, std::size_t dropped)
+	{
+		++rings;
+		turns += ring_turns;
+		pseudo_vertices += ring_pseudo_vertices;
+		rings_traced += traced;
+		rings_dropped += dropped;
+		max_ring_size = std::max(max_ring_size, ring_size);
+		max_pseudo_vertices = std::max(max_pseudo_vertices, ring_pseudo_vertices);
+		max_rings_traced = std::max(max_rings_traced, traced);
+	}
 
-		double length = boost::geometry::comparable_distance(ring[i], ring[j]);
-		if ((offset_1 > 0 && offset_1 < length) || (offset_2 > 0 && offset_2 < length)) {
-			pseudo_vertice_key key_j(j, i, offset_2);
-			pseudo_vertices.emplace(pseudo_vertice_key(i, j, offset_1, true), pseudo_vertice<point_t>(p, key_j));
-			pseudo_vertices.emplace(key_j, p);
-			start_keys.insert(key_j);
+	void add_overlay_call()
+	{
+		++overlay_calls;
+	}
 
-			pseudo_vertice_key key_i(i, j, offset_1);
-			pseudo_vertices.emplace(pseudo_vertice_key(j, i, offset_2, true), pseudo_vertice<point_t>(p, key_i));
-			pseudo_vertices.emplace(key_i, p);
-			start_keys.insert(key_i);
-		}
+	correct_statistics &operator+=(correct_statistics const &other)
+	{
+		for(std::size_t i = 0; i < time.size(); ++i)
+			time[i] += other.time[i];
+		rings += other.rings;
+		turns += other.turns;
+		pseudo_vertices += other.pseudo_vertices;
+		rings_traced += other.rings_traced;
+		rings_dropped += other.rings_dropped;
+		overlay_calls += other.overlay_calls;
+		max_ring_size = std::max(max_ring_size, other.max_ring_size);
+		max_pseudo_vertices = std::max(max_pseudo_vertices, other.max_pseudo_vertices);
+		max_rings_traced = std::max(max_rings_traced, other.max_rings_traced);
+		return *this;
 	}
-}
+};
 
-// Remove invalid points (NaN) from ring
-template<
-	typename point_t = boost::geometry::model::d2::point_xy<double>, 
-	typename ring_t = boost::geometry::model::ring<point_t>
-	>
-static inline void correct_invalid(ring_t &ring)
+static inline std::ostream &operator<<(std::ostream &out, correct_statistics const &statistics)
 {
-	for(auto i = ring.begin(); i != ring.end(); ) {
-		if(!boost::geometry::is_valid(*i))
-			i = ring.erase(i);
-		else
-			++i;
-	}	
-}
+	char const *stages[] = { "compact", "intersections", "trace", "fill", "combine" };
+	for(std::size_t i = 0; i < statistics.time.size(); ++i)
+		out << stages[i] << ": " << std::chrono::duration<double, std::milli>(statistics.time[i]).count() << " ms" << std::endl;
 
-// Correct orientation of ring
-template<
-	typename point_t = boost::geometry::model::d2::point_xy<double>, 
-	typename ring_t = boost::geometry::model::ring<point_t>
-	>
-static inline double correct_orientation(ring_t &ring, boost::geometry::order_selector order)
-{
-	auto area = boost::geometry::area(ring);
-	bool should_reverse =
-		(order == boost::geometry::clockwise && area < 0) ||
-		(order == boost::geometry::counterclockwise && area > 0);
+	out << "rings: " << statistics.rings << " (max size " << statistics.max_ring_size << ")" << std::endl;
+	out << "turns: " << statistics.turns << std::endl;
+	out << "pseudo-vertices: " << statistics.pseudo_vertices << " (max " << statistics.max_pseudo_vertices << ")" << std::endl;
+	out << "rings traced: " << statistics.rings_traced << " (max " << statistics.max_rings_traced << "), dropped: " << statistics.rings_dropped << std::endl;
+	out << "overlay calls: " << statistics.overlay_calls << std::endl;
+	return out;
+}
 
-	if(should_reverse) {
-		std::reverse(ring.begin(), ring.end());
-	} 
+namespace impl {
 
-	return area;
-}
+// Statistics which records nothing, all calls are removed by the compiler
+struct no_statistics
+{
+	void add_time(correct_stage, std::chrono::steady_clock::duration) { }
+	void add_ring(std::size_t, std::size_t, std::size_t, std::size_t, std::size_t) { }
+	void add_overlay_call() { }
+};
 
-// Close ring if not closed
-template<
-	typename point_t = boost::geometry::model::d2::point_xy<double>, 
-	typename ring_t = boost::geometry::model::ring<point_t>
-	>
-static inline void correct_close(ring_t &ring)
+// Record the time of a stage until the end of the scope
+template<typename statistics_t>
+struct stage_timer
 {
-	// Close ring if not closed
-	if(!ring.empty() && !boost::geometry::equals(ring.back(), ring.front()))
-		ring.push_back(ring.front());
+	statistics_t &statistics;
+	correct_stage stage;
+	std::chrono::steady_clock::time_point start;
 
-}
+	stage_timer(statistics_t &statistics, correct_stage stage)
+		: statistics(statistics), stage(stage), start(std::chrono::steady_clock::now())
+	{ }
 
-template< typename point_t = boost::geometry::model::d2::point_xy<double> >
-struct compare_point_less
-{
-    bool operator()(point_t const &a, point_t const &b) const {
-        if(a.x() < b.x()) return true;
-        if(a.x() > b.x()) return false;
-        return (a.y() < b.y());
-    };
+	~stage_timer()
+	{
+		statistics.add_time(stage, std::chrono::steady_clock::now() - start);
+	}
 };
 
-template<
-	typename point_t = boost::geometry::model::d2::point_xy<double>, 
-	typename ring_t = boost::geometry::model::ring<point_t>
-	>
-static inline std::vector<std::pair<ring_t, double>> dissolve_generate_rings(
-			std::map<pseudo_vertice_key, pseudo_vertice<point_t>, compare_pseudo_vertice_key> &pseudo_vertices,
-    		std::set<pseudo_vertice_key, compare_pseudo_vertice_key> const &all_start_keys, 
-			boost::geometry::order_selector order, double remove_spike_min_area = 0.0)
+template<>
+struct stage_timer<no_statistics>
 {
-	std::vector<std::pair<ring_t,double>> result;
-
-	// Generate all polygons by tracing all the intersections
-	// Perform union to combine all polygons into single polygon again
-	auto start_keys = all_start_keys;
-    while(!start_keys.empty()) {    
-		ring_t new_ring;
+	stage_timer(no_statistics &, correct_stage)
+	{ }
+};
 
-		// Store point in generated polygon
-		auto push_point = [&new_ring](auto const &p) { 
-            if(new_ring.empty() || boost::geometry::comparable_distance(new_ring.back(), p) > 0) {
-                new_ring.push_back(p);
-			}
-		};
+// Combines polygons into a set of polygons which do not overlap. The envelopes
+// of the combined polygons are stored in an rtree, so that a new polygon is only 
+// tested against the polygons it might intersect.
+template<typename multi_polygon_t>
+class result_combine_index
+{
+	typedef typename boost::range_value<multi_polygon_t>::type polygon_t;
+	typedef typename boost::geometry::point_type<polygon_t>::type point_t;
+	typedef boost::geometry::model::box<point_t> box_t;
+	typedef std::pair<box_t, std::size_t> value_t;
+	typedef boost::geometry::index::rtree<value_t, boost::geometry::index::rstar<16>> rtree_t;
 
-		// Store newly generated ring
-		auto push_ring = [&result, remove_spike_min_area](ring_t &new_ring) {
-			auto area = boost::geometry::area(new_ring);
-			if(std::abs(area) > remove_spike_min_area) {
-		    	result.push_back(std::make_pair(std::move(new_ring), area));
-			}
-		};
+	multi_polygon_t polygons;
+	std::vector<bool> removed;
+	std::vector<std::size_t> tested;
+	std::size_t stamp = 0;
+	rtree_t index;
 
-        auto i = pseudo_vertices.find(*start_keys.begin());		
-    
-    	std::vector< std::pair<point_t, std::size_t> > start_points;
-		start_points.push_back(std::make_pair(i->second.p, 0));
+public:
+	result_combine_index() = default;
 
-		// Check if the outer or inner ring is closed
-		auto is_closed = [&new_ring, &start_points, &push_ring](point_t const &p) {
-			for(auto const &i: start_points) {
-				if(new_ring.size() > i.second+1 && boost::geometry::comparable_distance(i.first, p) == 0) {
-					if(i.second == 0) return true;
+	// Start with already combined polygons, these should not overlap each other
+	explicit result_combine_index(multi_polygon_t &&initial)
+		: polygons(std::move(initial)), removed(polygons.size(), false), tested(polygons.size(), 0)
+	{
+		std::vector<value_t> values;
+		values.reserve(polygons.size());
+		for(std::size_t i = 0; i < polygons.size(); ++i)
+			values.emplace_back(boost::geometry::return_envelope<box_t>(polygons[i]), i);
 
-					// Copy the new inner ring
-					ring_t inner_ring(new_ring.begin() + i.second, new_ring.end());
-					push_ring(inner_ring);
+		// Bulk load the index
+		index = rtree_t(values.begin(), values.end());
+	}
 
-					// Remove the inner ring
-					new_ring.erase(new_ring.begin() + i.second, new_ring.end());
-				}
-			}
-			return false;
-		};
+	template<typename T>
+	void insert(T &&new_element)
+	{
+		polygon_t element(std::forward<T>(new_element));
+		box_t box = boost::geometry::return_envelope<box_t>(element);
 
-        do {
-            auto const &key = i->first;
-            auto const &value = i->second;
-        
-			// Store the point in output polygon
-			push_point(value.p);
-            
-			// Remove the key from the starting keys list
-			auto compare_key = [&key](pseudo_vertice_key const &i) {
-				return (key.index_1 == i.index_1 && key.index_2 == i.index_2 && key.scale == i.scale && key.reroute == i.reroute);
-			};
+		// Polygons which did not combine with the new element are not tested again
+		++stamp;
 
-			start_keys.erase(key);
+		// Like a linear scan, polygons combined before the last merged polygon
+		// are not considered again
+		std::size_t first = 0;
 
-			// Store possible new inner ring starting point
-			if(all_start_keys.find(key) != all_start_keys.end())
-				start_points.push_back(std::make_pair(value.p, new_ring.size() - 1));
+		std::vector<value_t> candidates;
+		for(bool merged = true; merged; ) {
+			merged = false;
 
-            if(key.reroute) {
-				// Follow by-pass
-                i = pseudo_vertices.find(value.link);
-			} else {
-				// Continu following original polygon
-                ++i;
-                if(i == pseudo_vertices.end())
-                    i = pseudo_vertices.begin();
-            }
+			candidates.clear();
+			index.query(boost::geometry::index::intersects(box), std::back_inserter(candidates));
 
-			// Repeat until back at starting point
-		} while(!is_closed(new_ring.back()));
+			// Test the candidates in the order they were combined
+			std::sort(candidates.begin(), candidates.end(), [](value_t const &a, value_t const &b) { return a.second < b.second; });
 
-		// Combine with already generated polygons
-		push_ring(new_ring);
-   	}
+			for(auto const &candidate: candidates) {
+				std::size_t i = candidate.second;
+				if(i < first || tested[i] == stamp)
+					continue;
 
-    return result;
-}
+				tested[i] = stamp;
+				if(!boost::geometry::intersects(polygons[i], element))
+					continue;
 
-template<
-	typename point_t = boost::geometry::model::d2::point_xy<double>, 
-	typename polygon_t = boost::geometry::model::polygon<point_t>,
-	typename ring_t = boost::geometry::model::ring<point_t>,
-	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>
-	>
-static inline std::vector<std::pair<ring_t, double>> correct(ring_t const &ring, boost::geometry::order_selector order, double remove_spike_min_area = 0.0)
-{
-	constexpr std::size_t min_nodes = 3;
-	if(ring.size() < min_nodes)
-		return { };
+				std::vector<polygon_t> union_result;
+				boost::geometry::union_(polygons[i], element, union_result);
 
-    std::map<pseudo_vertice_key, pseudo_vertice<point_t>, compare_pseudo_vertice_key> pseudo_vertices;    
-    std::set<pseudo_vertice_key, compare_pseudo_vertice_key> start_keys;
+				if(union_result.size() != 1)
+					continue;
 
-	ring_t new_ring = ring;
+				element = std::move(union_result[0]);
+				index.remove(candidate);
+				removed[i] = true;
+				first = i + 1;
 
-	// Remove invalid coordinates
-	correct_invalid(new_ring);
+				// Envelope has grown, query again for new candidates
+				box = boost::geometry::return_envelope<box_t>(element);
+				merged = true;
+				break;
+			}
+		}
 
-	// Close ring
-	correct_close(new_ring);
+		index.insert(value_t(box, polygons.size()));
+		polygons.push_back(std::move(element));
+		removed.push_back(false);
+		tested.push_back(0);
+	}
 
-	// Correct orientation
-	correct_orientation(new_ring, order);
+	template<typename T>
+	void insert_multiple(T &new_elements)
+	{
+		for(auto &element: new_elements)
+			insert(std::move(element));
+	}
 
-	// Detect self-intersection points
-	dissolve_find_intersections(new_ring, pseudo_vertices, start_keys);
+	// Move the combined polygons to the output, in the order they were combined
+	void release(multi_polygon_t &output)
+	{
+		output.clear();
+		for(std::size_t i = 0; i < polygons.size(); ++i) {
+			if(!removed[i])
+				output.push_back(std::move(polygons[i]));
+		}
 
-	if(start_keys.empty()) {
-		double area = boost::geometry::area(new_ring);
-		if(std::abs(area) > remove_spike_min_area) 
-			return { std::make_pair(new_ring, area) };
-		else
-			return { };
+		polygons.clear();
+		removed.clear();
+		tested.clear();
+		index.clear();
 	}
+};
 
-	return dissolve_generate_rings(pseudo_vertices, start_keys, order, remove_spike_min_area);
+template<typename C, typename T>
+static inline void result_combine(C &result, T &&new_element)
+{
+	result_combine_index<C> combined(std::move(result));
+	combined.insert(std::forward<T>(new_element));
+	combined.release(result);
 }
 
-template<
-	typename point_t = boost::geometry::model::d2::point_xy<double>, 
-	typename polygon_t = boost::geometry::model::polygon<point_t>,
-	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>
-	>
-static inline void fill_normalize_polygons(std::vector<std::pair<multi_polygon_t,double>> &input)
+template<typename C, typename T>
+static inline void result_combine_multiple(C &result, T &new_elements)
 {
-	for(auto &i: input) {
-		for(auto &poly: i.first) {
-			if(i.second < 0) {
-				std::reverse(poly.outer().begin(), poly.outer().end());
-			}
-		}
-	}
+	result_combine_index<C> combined(std::move(result));
+	combined.insert_multiple(new_elements);
+	combined.release(result);
 }
 
-template<
-	typename point_t = boost::geometry::model::d2::point_xy<double>, 
-	typename polygon_t = boost::geometry::model::polygon<point_t>,
-	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>
-	>
-struct fill_non_zero_winding
+// Key of the position of a point along the Z-order curve within the given box
+template<typename point_t, typename box_t>
+static inline std::uint32_t z_order_key(point_t const &p, box_t const &bounds)
 {
-	inline void operator()(std::vector<std::pair<multi_polygon_t, double>> &input) const
-	{
-		auto compare = [](std::pair<multi_polygon_t, double> const &a, std::pair<multi_polygon_t, double> const &b) { return std::abs(a.second) > std::abs(b.second); };
-		std::sort(input.begin(), input.end(), compare);
+	auto scaled = [](double v, double min, double max) -> std::uint32_t {
+		if(!(max > min)) return 0;
+		return static_cast<std::uint32_t>(std::min(std::max((v - min) / (max - min), 0.0), 1.0) * 0xFFFF);
+	};
 
-		std::vector<int> scores;
-		for(auto &mp: input) {
-			scores.push_back(mp.second > 0 ? 1 : -1);
-		}
+	std::uint32_t x = scaled(boost::geometry::get<0>(p), boost::geometry::get<boost::geometry::min_corner, 0>(bounds), boost::geometry::get<boost::geometry::max_corner, 0>(bounds));
+	std::uint32_t y = scaled(boost::geometry::get<1>(p), boost::geometry::get<boost::geometry::min_corner, 1>(bounds), boost::geometry::get<boost::geometry::max_corner, 1>(bounds));
 
-		fill_normalize_polygons(input);
+	std::uint32_t key = 0;
+	for(std::uint32_t bit = 0; bit < 16; ++bit)
+		key |= ((x >> bit) & 1u) << (2 * bit) | ((y >> bit) & 1u) << (2 * bit + 1);
+	return key;
+}
 
-		for(std::size_t i = 0; i < input.size(); ++i) {
-			for(std::size_t j = i + 1; j < input.size(); ++j) {
-				if(boost::geometry::covered_by(input[j].first, input[i].first)) { 
-					scores[j] += scores[i];
-				}
-			}
-		}
+// Combine polygons using a cascaded union. Polygons already in the result which 
+// might touch a new polygon are taken out of the result. These and the new polygons 
+// are sorted along a space filling curve and unioned pairwise, level by level, 
+// so most unions are between nearby polygons of similar size.
+template<typename C, typename T>
+static inline void result_combine_cascaded(C &result, T &new_elements)
+{
+	typedef typename boost::range_value<C>::type polygon_t;
+	typedef typename boost::geometry::point_type<polygon_t>::type point_t;
+	typedef boost::geometry::model::box<point_t> box_t;
+	typedef std::pair<box_t, std::size_t> value_t;
 
-		multi_polygon_t combined_outers;
-		multi_polygon_t combined_inners;
+	if(boost::empty(new_elements))
+		return;
 
-		for(std::size_t i = 0; i < input.size(); ++i) {
-			if(scores[i] != 0)
-				result_combine_multiple(combined_outers, input[i].first);
-			else
-				result_combine_multiple(combined_inners, input[i].first);
-		}
+	std::vector<std::pair<box_t, polygon_t>> parts;
+	for(auto &element: new_elements) {
+		polygon_t poly(std::move(element));
+		box_t box = boost::geometry::return_envelope<box_t>(poly);
+		parts.emplace_back(box, std::move(poly));
+	}
 
-		multi_polygon_t output;
-		boost::geometry::difference(combined_outers, combined_inners, output);
+	// Find the polygons in the result which might be touched by the new polygons
+	std::vector<value_t> values;
+	values.reserve(result.size());
+	for(std::size_t i = 0; i < result.size(); ++i)
+		values.emplace_back(boost::geometry::return_envelope<box_t>(result[i]), i);
 
-		input.resize(1);
-		input.front().first = std::move(output);
+	boost::geometry::index::rtree<value_t, boost::geometry::index::rstar<16>> index(values.begin(), values.end());
+
+	std::vector<bool> touched(result.size(), false);
+	std::size_t new_count = parts.size();
+	for(std::size_t i = 0; i < new_count; ++i) {
+		index.query(boost::geometry::index::intersects(parts[i].first), 
+			boost::make_function_output_iterator([&touched](value_t const &v) { touched[v.second] = true; }));
 	}
-};
 
-template<
-	typename point_t = boost::geometry::model::d2::point_xy<double>, 
-	typename polygon_t = boost::geometry::model::polygon<point_t>,
-	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>
-	>
-struct fill_odd_even
+	C untouched;
+	for(std::size_t i = 0; i < result.size(); ++i) {
+		if(touched[i])
+			parts.emplace_back(values[i].first, std::move(result[i]));
+		else
+			untouched.push_back(std::move(result[i]));
+	}
+
+	if(parts.size() == 1) {
+		result = std::move(untouched);
+		result.push_back(std::move(parts.front().second));
+		return;
+	}
+
+	// Sort on the center of the envelopes
+	box_t bounds;
+	boost::geometry::assign_inverse(bounds);
+	for(auto const &part: parts)
+		boost::geometry::expand(bounds, part.first);
+
+	std::vector<std::pair<std::uint32_t, std::size_t>> order;
+	order.reserve(parts.size());
+	for(std::size_t i = 0; i < parts.size(); ++i) {
+		point_t center;
+		boost::geometry::centroid(parts[i].first, center);
+		order.emplace_back(z_order_key(center, bounds), i);
+	}
+	std::sort(order.begin(), order.end());
+
+	std::vector<std::pair<box_t, C>> level;
+	level.reserve(order.size());
+	for(auto const &i: order) {
+		level.emplace_back(parts[i.second].first, C());
+		level.back().second.push_back(std::move(parts[i.second].second));
+	}
+
+	// Union pairs of neighbours until a single multi polygon is left, 
+	// neighbours with disjoint envelopes are just collected
+	while(level.size() > 1) {
+		std::vector<std::pair<box_t, C>> next;
+		next.reserve(level.size() / 2 + 1);
+		for(std::size_t i = 0; i + 1 < level.size(); i += 2) {
+			auto &a = level[i];
+			auto &b = level[i + 1];
+
+			box_t box = a.first;
+			boost::geometry::expand(box, b.first);
+			next.emplace_back(box, C());
+
+			box_t common;
+			if(!boost::geometry::intersection(a.first, b.first, common)) {
+				next.back().second = std::move(a.second);
+				for(auto &poly: b.second)
+					next.back().second.push_back(std::move(poly));
+				continue;
+			}
+
+			// Only polygons crossing the common part of both envelopes take part in the union
+			C overlay_a, overlay_b;
+			auto split = [&common, &next](C &input, C &overlay) {
+				for(auto &poly: input) {
+					if(boost::geometry::intersects(boost::geometry::return_envelope<box_t>(poly), common))
+						overlay.push_back(std::move(poly));
+					else
+						next.back().second.push_back(std::move(poly));
+				}
+			};
+			split(a.second, overlay_a);
+			split(b.second, overlay_b);
+
+			if(overlay_a.empty() || overlay_b.empty()) {
+				for(auto &poly: overlay_a) next.back().second.push_back(std::move(poly));
+				for(auto &poly: overlay_b) next.back().second.push_back(std::move(poly));
+				continue;
+			}
+
+			C unioned;
+			boost::geometry::union_(overlay_a, overlay_b, unioned);
+			for(auto &poly: unioned)
+				next.back().second.push_back(std::move(poly));
+		}
+		if(level.size() % 2 == 1)
+			next.push_back(std::move(level.back()));
+		level = std::move(next);
+	}
+
+	result = std::move(untouched);
+	for(auto &poly: level.front().second)
+		result.push_back(std::move(poly));
+}
+
+template< typename point_t = boost::geometry::model::d2::point_xy<double> >
+struct compare_point_less
+{
+    bool operator()(point_t const &a, point_t const &b) const {
+        if(boost::geometry::get<0>(a) < boost::geometry::get<0>(b)) return true;
+        if(boost::geometry::get<0>(a) > boost::geometry::get<0>(b)) return false;
+        return (boost::geometry::get<1>(a) < boost::geometry::get<1>(b));
+    };
+};
+
+// Offset of point p along segment a-b, measured along the axis in which the segment is longest. 
+// Offsets are exact for integer coordinates and at least double for floating point coordinates.
+template<typename point_t>
+struct segment_offset
+{
+	typedef typename boost::geometry::coordinate_type<point_t>::type coordinate_t;
+	typedef typename std::conditional<std::is_integral<coordinate_t>::value, 
+		std::int64_t, 
+		typename boost::geometry::select_most_precise<coordinate_t, double>::type>::type type;
+
+	static inline type apply(point_t const &a, point_t const &b, point_t const &p)
+	{
+		type dx = type(boost::geometry::get<0>(b)) - type(boost::geometry::get<0>(a));
+		type dy = type(boost::geometry::get<1>(b)) - type(boost::geometry::get<1>(a));
+		if(std::abs(dx) >= std::abs(dy))
+			return std::abs(type(boost::geometry::get<0>(p)) - type(boost::geometry::get<0>(a)));
+		return std::abs(type(boost::geometry::get<1>(p)) - type(boost::geometry::get<1>(a)));
+	}
+};
+
+template<typename offset_t = double>
+struct pseudo_vertice_key
+{
+    std::size_t index_1;
+    offset_t scale;
+    std::size_t index_2;
+    bool reroute;
+    
+    pseudo_vertice_key(std::size_t index_1 = 0, std::size_t index_2 = 0, offset_t scale = 0, bool reroute = false)
+        : index_1(index_1), scale(scale), index_2(index_2), reroute(reroute)
+    { } 
+};
+
+struct compare_pseudo_vertice_key
+{
+	template<typename key_t>
+    bool operator()(key_t const &a, key_t const &b) const {
+        if(a.index_1 < b.index_1) return true;
+        if(a.index_1 > b.index_1) return false;
+        if(a.scale < b.scale) return true;
+        if(a.scale > b.scale) return false;
+        if(a.index_2 > b.index_2) return true;
+        if(a.index_2 < b.index_2) return false;
+        if(a.reroute && !b.reroute) return true;
+        if(!a.reroute && b.reroute) return false;
+		return false;
+    }
+};
+
+template<typename point_t = boost::geometry::model::d2::point_xy<double>>
+struct pseudo_vertice
+{
+    typedef pseudo_vertice_key<typename segment_offset<point_t>::type> key_t;
+
+    point_t p;
+    key_t link;
+    std::size_t link_index;
+    std::size_t point_id;
+    bool start;
+    
+    pseudo_vertice(point_t p, key_t link = key_t())   
+        : p(p), link(link), link_index(0), point_id(0), start(false)
+    { }        
+};
+
+// All ring vertices and pseudo-vertices in a single vector sorted on key. After 
+// build, links are resolved to indices, start keys are flagged on the vertex and 
+// vertices at the same point share a point id.
+template<typename point_t = boost::geometry::model::d2::point_xy<double>>
+struct pseudo_vertice_graph
+{
+	typedef typename segment_offset<point_t>::type offset_t;
+	typedef pseudo_vertice_key<offset_t> key_t;
+
+	// Intersection of segments index_1 < index_2 at the offsets from their start points
+	struct intersection
+	{
+		std::size_t index_1;
+		std::size_t index_2;
+		offset_t offset_1;
+		offset_t offset_2;
+		point_t p;
+	};
+
+	std::pmr::vector<intersection> intersections;
+	std::pmr::vector<std::pair<key_t, pseudo_vertice<point_t>>> vertices;
+	std::pmr::vector<key_t> start_keys;
+	std::size_t start_count = 0;
+	std::size_t point_count = 0;
+
+	// Traced rings with an area below the minimum area
+	std::size_t dropped_count = 0;
+
+	// Vertices visited while tracing the rings, position of a start point in the 
+	// traced ring by point id and the point id of every point of the traced ring
+	std::pmr::vector<bool> visited;
+	std::pmr::vector<std::size_t> positions;
+	std::pmr::vector<std::size_t> ring_points;
+
+	explicit pseudo_vertice_graph(std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+		: intersections(resource), vertices(resource), start_keys(resource), visited(resource), positions(resource), ring_points(resource)
+	{ }
+
+	void clear()
+	{
+		intersections.clear();
+		vertices.clear();
+		start_keys.clear();
+		start_count = 0;
+		point_count = 0;
+		dropped_count = 0;
+		visited.clear();
+		positions.clear();
+		ring_points.clear();
+	}
+
+	std::size_t find(key_t const &key) const
+	{
+		auto i = std::lower_bound(vertices.begin(), vertices.end(), key, 
+			[](std::pair<key_t, pseudo_vertice<point_t>> const &a, key_t const &b) { return compare_pseudo_vertice_key()(a.first, b); });
+		return i - vertices.begin();
+	}
+
+	void build()
+	{
+		compare_pseudo_vertice_key compare;
+
+		// Sort once, the first added vertex of a key is kept
+		std::stable_sort(vertices.begin(), vertices.end(), 
+			[&compare](std::pair<key_t, pseudo_vertice<point_t>> const &a, std::pair<key_t, pseudo_vertice<point_t>> const &b) { return compare(a.first, b.first); });
+		vertices.erase(std::unique(vertices.begin(), vertices.end(), 
+			[&compare](std::pair<key_t, pseudo_vertice<point_t>> const &a, std::pair<key_t, pseudo_vertice<point_t>> const &b) { return !compare(a.first, b.first) && !compare(b.first, a.first); }), 
+			vertices.end());
+
+		for(auto &i: vertices) {
+			if(i.first.reroute)
+				i.second.link_index = find(i.second.link);
+		}
+
+		start_count = 0;
+		for(auto const &key: start_keys) {
+			auto &vertice = vertices[find(key)].second;
+			if(!vertice.start) {
+				vertice.start = true;
+				++start_count;
+			}
+		}
+
+		// Number the distinct points, ring_points is used as scratch for the vertex order
+		compare_point_less<point_t> less;
+		ring_points.resize(vertices.size());
+		for(std::size_t i = 0; i < vertices.size(); ++i)
+			ring_points[i] = i;
+		std::sort(ring_points.begin(), ring_points.end(), 
+			[this, &less](std::size_t a, std::size_t b) { return less(vertices[a].second.p, vertices[b].second.p); });
+
+		point_count = 0;
+		for(std::size_t i = 0; i < ring_points.size(); ++i) {
+			if(i > 0 && less(vertices[ring_points[i - 1]].second.p, vertices[ring_points[i]].second.p))
+				++point_count;
+			vertices[ring_points[i]].second.point_id = point_count;
+		}
+		if(!vertices.empty())
+			++point_count;
+		ring_points.clear();
+	}
+};
+
+struct assign_policy    {
+	static bool const include_no_turn = true;
+	static bool const include_degenerate = true;
+	static bool const include_opposite = true;
+	static bool const include_start_turn = true;
+};
+
+// Find the intersections of the segments of a ring with boost::geometry::self_turns. All turns, 
+// including degenerate and opposite turns, are reported as segment indices i < j and the turn point.
+template<typename turns_t>
+struct self_turns_intersections
+{
+	turns_t &turns;
+
+	template<typename ring_t, typename visitor_t>
+	void operator()(ring_t const &ring, visitor_t const &visit) const
+	{
+		boost::geometry::strategies::cartesian<> strategy;
+		typedef boost::geometry::detail::no_rescale_policy rescale_policy_type;
+
+		turns.clear();
+
+		rescale_policy_type rescale_policy;
+
+		boost::geometry::detail::self_get_turn_points::no_interrupt_policy policy;
+		boost::geometry::self_turns
+			<
+				assign_policy
+			>(ring, strategy, rescale_policy, turns, policy);
+
+		for(auto const &turn: turns) {
+			auto i = std::min(turn.operations[0].seg_id.segment_index, turn.operations[1].seg_id.segment_index);
+			auto j = std::max(turn.operations[0].seg_id.segment_index, turn.operations[1].seg_id.segment_index);
+			visit(i, j, turn.point);
+		}
+	}
+};
+
+// Orientation of point c to the line a-b, positive when c is left of a-b. The determinant is 
+// computed in double precision. Only when it is smaller than its error bound, it is evaluated 
+// exactly with expansion arithmetic, so the sign is always exact (Shewchuk's filtered orient2d).
+struct orientation
+{
+	static inline void two_sum(double a, double b, double &x, double &y)
+	{
+		x = a + b;
+		double bv = x - a;
+		double av = x - bv;
+		y = (a - av) + (b - bv);
+	}
+
+	// Split a in two halves of 26 bits, of which the products are exact (Dekker)
+	static inline void split(double a, double &high, double &low)
+	{
+		constexpr double splitter = 134217729.0;
+		double c = splitter * a;
+		high = c - (c - a);
+		low = a - high;
+	}
+
+	static inline void two_product(double a, double b, double &x, double &y)
+	{
+		x = a * b;
+		double ah, al, bh, bl;
+		split(a, ah, al);
+		split(b, bh, bl);
+		y = al * bl - (((x - ah * bh) - al * bh) - ah * bl);
+	}
+
+	static inline double exact(double ax, double ay, double bx, double by, double cx, double cy)
+	{
+		// The determinant as the sum of the exact products ax by - ay bx + bx cy - by cx + cx ay - cy ax
+		double terms[12];
+		two_product(ax, by, terms[0], terms[1]);
+		two_product(-ay, bx, terms[2], terms[3]);
+		two_product(bx, cy, terms[4], terms[5]);
+		two_product(-by, cx, terms[6], terms[7]);
+		two_product(cx, ay, terms[8], terms[9]);
+		two_product(-cy, ax, terms[10], terms[11]);
+
+		// Grow a non-overlapping expansion, with the components in increasing magnitude
+		double expansion[12];
+		std::size_t size = 0;
+		for(double term: terms) {
+			double q = term;
+			for(std::size_t i = 0; i < size; ++i)
+				two_sum(q, expansion[i], q, expansion[i]);
+			expansion[size++] = q;
+		}
+
+		// The sign of the sum is the sign of its most significant component
+		double sum = 0;
+		for(std::size_t i = 0; i < size; ++i)
+			sum += expansion[i];
+		for(std::size_t i = size; i-- > 0; ) {
+			if(expansion[i] != 0)
+				return (expansion[i] > 0 && sum > 0) || (expansion[i] < 0 && sum < 0) ? sum : expansion[i];
+		}
+		return 0;
+	}
+
+	// The point is near the line when the determinant is within its error bound
+	static inline double apply(double ax, double ay, double bx, double by, double cx, double cy, bool &near)
+	{
+		constexpr double epsilon = std::numeric_limits<double>::epsilon() / 2;
+		constexpr double error_bound = (3.0 + 16.0 * epsilon) * epsilon;
+
+		double left = (bx - ax) * (cy - ay);
+		double right = (by - ay) * (cx - ax);
+		double det = left - right;
+		near = !(std::abs(det) > error_bound * (std::abs(left) + std::abs(right)));
+		if(!near)
+			return det;
+
+		// Shared points, like the point between consecutive segments, are on the line
+		if((cx == ax && cy == ay) || (cx == bx && cy == by))
+			return 0;
+		return exact(ax, ay, bx, by, cx, cy);
+	}
+
+	static inline double apply(double ax, double ay, double bx, double by, double cx, double cy)
+	{
+		bool near;
+		return apply(ax, ay, bx, by, cx, cy, near);
+	}
+};
+
+// Intersections of two segments a-b and c-d. Crossing segments report the crossing point, 
+// touching and collinear segments report the end points lying on the other segment. When an 
+// end point is near the other segment, the crossing point is snapped to the end point, so 
+// crossings near a vertex are reported at the same point for both segments of the vertex.
+struct segment_intersection
+{
+	template<std::size_t dimension, typename point_t>
+	static inline double get(point_t const &p)
+	{
+		return double(boost::geometry::get<dimension>(p));
+	}
+
+	template<typename point_t>
+	static inline double side(point_t const &a, point_t const &b, point_t const &c, bool &near)
+	{
+		return orientation::apply(get<0>(a), get<1>(a), get<0>(b), get<1>(b), get<0>(c), get<1>(c), near);
+	}
+
+	// Coordinate of the crossing point along one axis, kept within the overlap of the ranges of 
+	// both segments, so rounding does not move the point off the segments' envelopes
+	static inline double crossing(double a, double b, double c, double d, double t)
+	{
+		double v = a + t * (b - a);
+		double low = std::max(std::min(a, b), std::min(c, d));
+		double high = std::min(std::max(a, b), std::max(c, d));
+		return std::min(std::max(v, low), high);
+	}
+
+	// Coordinate of an intersection point, integer coordinates are rounded to the grid
+	template<typename coordinate_t>
+	static inline coordinate_t coordinate(double v)
+	{
+		if(std::is_integral<coordinate_t>::value)
+			return coordinate_t(std::llround(v));
+		return coordinate_t(v);
+	}
+
+	// Point p, collinear with segment a-b, lies on the segment
+	template<typename point_t>
+	static inline bool on_segment(point_t const &p, point_t const &a, point_t const &b)
+	{
+		return boost::geometry::get<0>(p) >= std::min(boost::geometry::get<0>(a), boost::geometry::get<0>(b))
+			&& boost::geometry::get<0>(p) <= std::max(boost::geometry::get<0>(a), boost::geometry::get<0>(b))
+			&& boost::geometry::get<1>(p) >= std::min(boost::geometry::get<1>(a), boost::geometry::get<1>(b))
+			&& boost::geometry::get<1>(p) <= std::max(boost::geometry::get<1>(a), boost::geometry::get<1>(b));
+	}
+
+	template<typename point_t, typename visitor_t>
+	static inline void apply(point_t const &a, point_t const &b, point_t const &c, point_t const &d, visitor_t const &visit)
+	{
+		typedef typename boost::geometry::coordinate_type<point_t>::type coordinate_t;
+
+		if(std::max(boost::geometry::get<1>(a), boost::geometry::get<1>(b)) < std::min(boost::geometry::get<1>(c), boost::geometry::get<1>(d))
+			|| std::max(boost::geometry::get<1>(c), boost::geometry::get<1>(d)) < std::min(boost::geometry::get<1>(a), boost::geometry::get<1>(b)))
+			return;
+
+		bool near1, near2, near3, near4;
+		double o1 = side(a, b, c, near1);
+		double o2 = side(a, b, d, near2);
+		double o3 = side(c, d, a, near3);
+		double o4 = side(c, d, b, near4);
+
+		if((o1 > 0 && o2 > 0) || (o1 < 0 && o2 < 0) || (o3 > 0 && o4 > 0) || (o3 < 0 && o4 < 0))
+			return;
+
+		if(o1 != 0 && o2 != 0 && o3 != 0 && o4 != 0) {
+			if(near3) { visit(a); return; }
+			if(near4) { visit(b); return; }
+			if(near1) { visit(c); return; }
+			if(near2) { visit(d); return; }
+
+			double t = o3 / (o3 - o4);
+			point_t p;
+			boost::geometry::set<0>(p, coordinate<coordinate_t>(crossing(get<0>(a), get<0>(b), get<0>(c), get<0>(d), t)));
+			boost::geometry::set<1>(p, coordinate<coordinate_t>(crossing(get<1>(a), get<1>(b), get<1>(c), get<1>(d), t)));
+			visit(p);
+			return;
+		}
+
+		if(o3 == 0 && on_segment(a, c, d)) visit(a);
+		if(o4 == 0 && on_segment(b, c, d)) visit(b);
+		if(o1 == 0 && on_segment(c, a, b)) visit(c);
+		if(o2 == 0 && on_segment(d, a, b)) visit(d);
+	}
+};
+
+struct sweep_segment
+{
+	double min_x;
+	double max_x;
+	std::size_t index;
+};
+
+// Segments of the sweep which overlap the sweep line, as a structure of arrays so a new 
+// segment is tested against all of them in a single loop over contiguous coordinates
+struct sweep_active
+{
+	std::pmr::vector<double> min_y, max_y, max_x;
+	std::pmr::vector<std::size_t> index;
+	std::pmr::vector<std::uint8_t> candidate;
+
+	explicit sweep_active(std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+		: min_y(resource), max_y(resource), max_x(resource), index(resource), candidate(resource)
+	{ }
+
+	std::size_t size() const
+	{
+		return index.size();
+	}
+
+	void clear()
+	{
+		min_y.clear(); max_y.clear(); max_x.clear(); index.clear();
+	}
+
+	void push_back(double y1, double y2, double x, std::size_t i)
+	{
+		min_y.push_back(std::min(y1, y2));
+		max_y.push_back(std::max(y1, y2));
+		max_x.push_back(x);
+		index.push_back(i);
+	}
+
+	// Remove the segments left of the sweep line at x
+	void remove_left(double x)
+	{
+		std::size_t count = 0;
+		for(std::size_t k = 0; k < size(); ++k) {
+			if(max_x[k] < x)
+				continue;
+			min_y[count] = min_y[k]; max_y[count] = max_y[k]; max_x[count] = max_x[k]; index[count] = index[k];
+			++count;
+		}
+		min_y.resize(count); max_y.resize(count); max_x.resize(count); index.resize(count);
+	}
+};
+
+// Mark the active segments of which the envelope overlaps the y range of a new segment, and which
+// are not left of the sweep line at x. Returns the number of segments left of the sweep line.
+BOOST_GEOMETRY_CORRECT_TARGET_CLONES
+static inline std::size_t sweep_candidates(double const *__restrict min_y, double const *__restrict max_y, double const *__restrict max_x, std::size_t n, 
+	double y1, double y2, double x, std::uint8_t *__restrict candidate)
+{
+	std::size_t left = 0;
+
+	// Without branches, so the loop is vectorized
+	for(std::size_t k = 0; k < n; ++k) {
+		int active = max_x[k] >= x;
+		candidate[k] = std::uint8_t((max_y[k] >= y1) & (min_y[k] <= y2) & active);
+		left += std::size_t(active ^ 1);
+	}
+	return left;
+}
+
+// Find the intersections of the segments of a ring with a sweep over the segments sorted on 
+// their minimum x. Only segments which overlap in x are tested against each other.
+template<typename segments_t, typename active_t = sweep_active>
+struct sweep_intersections
+{
+	segments_t &segments;
+	active_t &active;
+
+	template<typename ring_t, typename visitor_t>
+	void operator()(ring_t const &ring, visitor_t const &visit) const
+	{
+		typedef typename boost::range_value<ring_t>::type point_t;
+
+		segments.clear();
+		active.clear();
+		for(std::size_t i = 0; i + 1 < ring.size(); ++i) {
+			double x1 = segment_intersection::get<0>(ring[i]);
+			double x2 = segment_intersection::get<0>(ring[i + 1]);
+			segments.push_back({ std::min(x1, x2), std::max(x1, x2), i });
+		}
+
+		std::sort(segments.begin(), segments.end(), 
+			[](sweep_segment const &a, sweep_segment const &b) { return a.min_x < b.min_x; });
+
+		for(auto const &segment: segments) {
+			point_t const &c = ring[segment.index];
+			point_t const &d = ring[segment.index + 1];
+
+			// Reject the active segments which do not overlap in a batch, the remaining 
+			// candidates are tested one by one
+			double y1 = segment_intersection::get<1>(c), y2 = segment_intersection::get<1>(d);
+			active.candidate.resize(active.size());
+			std::size_t left = sweep_candidates(active.min_y.data(), active.max_y.data(), active.max_x.data(), active.size(),
+				std::min(y1, y2), std::max(y1, y2), segment.min_x, active.candidate.data());
+
+			for(std::size_t k = 0; k < active.size(); ++k) {
+				if(!active.candidate[k])
+					continue;
+
+				auto i = std::min(segment.index, active.index[k]);
+				auto j = std::max(segment.index, active.index[k]);
+				segment_intersection::apply(ring[i], ring[i + 1], ring[j], ring[j + 1], [i, j, &visit](point_t const &p) { visit(i, j, p); });
+			}
+
+			// Remove the segments left of the sweep line, once they are a quarter of the active 
+			// segments. Until then they are skipped by the batch test.
+			if(4 * left > active.size())
+				active.remove_left(segment.min_x);
+
+			active.push_back(y1, y2, segment.max_x, segment.index);
+		}
+	}
+};
+
+// Monotonic section of a ring: consecutive segments along which the x and y coordinates do not 
+// change direction, so segments of a section only meet at their shared points
+template<typename box_t>
+struct ring_section
+{
+	box_t envelope;
+	std::size_t ring;
+	std::size_t begin;
+	std::size_t end;
+};
+
+// Monotonic sections of one or more rings, bulk loaded into a packed rtree. The envelopes of 
+// the segments are computed once, to find the pairs of sections which might intersect.
+template<typename point_t>
+struct section_index
+{
+	typedef boost::geometry::model::box<point_t> box_t;
+	typedef std::pair<box_t, std::size_t> value_t;
+	typedef boost::geometry::index::rtree<value_t, boost::geometry::index::rstar<16>> rtree_t;
+
+	static constexpr std::size_t max_section_segments = 16;
+
+	std::pmr::vector<ring_section<box_t>> sections;
+	std::pmr::vector<value_t> values;
+	rtree_t index;
+
+	explicit section_index(std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+		: sections(resource), values(resource)
+	{ }
+
+	void clear()
+	{
+		sections.clear();
+		values.clear();
+		index.clear();
+	}
+
+	template<typename ring_t>
+	void add(ring_t const &ring, std::size_t ring_index)
+	{
+		int dx = 0, dy = 0;
+		for(std::size_t i = 0; i + 1 < boost::size(ring); ++i) {
+			auto const &a = ring[i];
+			auto const &b = ring[i + 1];
+			int sx = (boost::geometry::get<0>(b) > boost::geometry::get<0>(a)) - (boost::geometry::get<0>(b) < boost::geometry::get<0>(a));
+			int sy = (boost::geometry::get<1>(b) > boost::geometry::get<1>(a)) - (boost::geometry::get<1>(b) < boost::geometry::get<1>(a));
+
+			// Start a new section when the direction changes or the section is full
+			bool same = !sections.empty() && sections.back().ring == ring_index && sections.back().end == i 
+				&& i - sections.back().begin < max_section_segments
+				&& (sx == 0 || dx == 0 || sx == dx) && (sy == 0 || dy == 0 || sy == dy);
+			if(!same) {
+				sections.push_back({ boost::geometry::return_envelope<box_t>(a), ring_index, i, i });
+				dx = dy = 0;
+			}
+
+			auto &section = sections.back();
+			boost::geometry::expand(section.envelope, b);
+			section.end = i + 1;
+			dx = sx != 0 ? sx : dx;
+			dy = sy != 0 ? sy : dy;
+		}
+	}
+
+	// Bulk load the rtree with the sections added
+	void build()
+	{
+		values.clear();
+		values.reserve(sections.size());
+		for(std::size_t i = 0; i < sections.size(); ++i)
+			values.emplace_back(sections[i].envelope, i);
+		index = rtree_t(values.begin(), values.end());
+	}
+
+	// Call visit(a, b) for every pair of sections a < b of which the envelopes intersect, 
+	// skipping the pairs of which both sections are before section first
+	template<typename visitor_t>
+	void query_pairs(visitor_t const &visit, std::size_t first = 0) const
+	{
+		for(std::size_t b = first; b < sections.size(); ++b) {
+			index.query(boost::geometry::index::intersects(sections[b].envelope), boost::make_function_output_iterator([b, &visit](value_t const &value) {
+				if(value.second < b)
+					visit(value.second, b);
+			}));
+		}
+	}
+};
+
+// Find the intersections of the segments of a ring by testing the segments of the pairs of 
+// monotonic sections with intersecting envelopes
+template<typename index_t>
+struct section_intersections
+{
+	index_t &index;
+
+	template<typename ring_t, typename visitor_t>
+	void operator()(ring_t const &ring, visitor_t const &visit) const
+	{
+		typedef typename boost::range_value<ring_t>::type point_t;
+
+		index.clear();
+		index.add(ring, 0);
+		index.build();
+
+		index.query_pairs([&ring, &visit, this](std::size_t a, std::size_t b) {
+			auto const &first = index.sections[a];
+			auto const &second = index.sections[b];
+			for(std::size_t i = first.begin; i < first.end; ++i) {
+				for(std::size_t j = second.begin; j < second.end; ++j)
+					segment_intersection::apply(ring[i], ring[i + 1], ring[j], ring[j + 1], [i, j, &visit](point_t const &p) { visit(i, j, p); });
+			}
+		});
+	}
+};
+
+// Snap rounding of rings with integer coordinates. The pixel of a grid point is the unit 
+// square centered at it. Every segment passing through the pixel of a vertex or of a crossing 
+// is routed through the grid point of that pixel (Hobby), and segments are split at the 
+// vertices lying on them. Afterwards segments only meet at their end points, so no 
+// intersection point has to be rounded. A rounded crossing point can touch or cross a nearby 
+// segment, making the corrected rings invalid.
+template<typename point_t>
+struct snap_rounding
+{
+	typedef typename boost::geometry::coordinate_type<point_t>::type coordinate_t;
+
+	// Grid point routed through by a segment of a ring, ordered along the segment by the 
+	// offsets along the axis in which the segment is longest and along the other axis
+	struct snap
+	{
+		std::size_t ring;
+		std::size_t index;
+		std::int64_t offset_1;
+		std::int64_t offset_2;
+		point_t p;
+	};
+
+	// Crossing points are computed in double, pixels within this distance of the crossing 
+	// point are hot as well. Crossings in pixels still missed are found in the next iteration.
+	static constexpr double pixel_tolerance = 1E-6;
+	static constexpr std::size_t max_iterations = 8;
+
+	section_index<point_t> sections;
+	std::pmr::vector<point_t> pixels;
+	std::pmr::vector<snap> snaps;
+
+	explicit snap_rounding(std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+		: sections(resource), pixels(resource), snaps(resource)
+	{ }
+
+	// Snap the rings, given as a range of pointers to rings, together. Returns false when 
+	// segments still cross or touch other than at their end points after the last iteration.
+	template<typename rings_t>
+	bool apply(rings_t const &rings)
+	{
+		typedef typename std::remove_pointer<typename boost::range_value<rings_t>::type>::type ring_t;
+
+		for(std::size_t iteration = 0; ; ++iteration) {
+			sections.clear();
+			for(std::size_t r = 0; r < boost::size(rings); ++r)
+				sections.add(*rings[r], r);
+			sections.build();
+
+			pixels.clear();
+			sections.query_pairs([this, &rings](std::size_t a, std::size_t b) {
+				auto const &first = sections.sections[a];
+				auto const &second = sections.sections[b];
+				auto const &ring_1 = *rings[first.ring];
+				auto const &ring_2 = *rings[second.ring];
+				for(std::size_t i = first.begin; i < first.end; ++i) {
+					for(std::size_t j = second.begin; j < second.end; ++j)
+						add_crossing(ring_1[i], ring_1[i + 1], ring_2[j], ring_2[j + 1]);
+				}
+			});
+			if(pixels.empty())
+				return true;
+			if(iteration == max_iterations)
+				return false;
+
+			// The vertices are hot as well, so a segment moved to a crossing pixel does not 
+			// pass a vertex on the other side
+			if(iteration == 0) {
+				for(auto const *ring: rings)
+					pixels.insert(pixels.end(), boost::begin(*ring), boost::end(*ring));
+			}
+			std::sort(pixels.begin(), pixels.end(), compare_point_less<point_t>());
+			pixels.erase(std::unique(pixels.begin(), pixels.end(), [](point_t const &a, point_t const &b) { 
+				return boost::geometry::equals(a, b); 
+			}), pixels.end());
+
+			// Segments passing through a hot pixel, the envelope of the section contains the 
+			// grid point of the pixel
+			snaps.clear();
+			for(auto const &p: pixels) {
+				sections.index.query(boost::geometry::index::intersects(p), boost::make_function_output_iterator([this, &rings, &p](typename section_index<point_t>::value_t const &value) {
+					auto const &section = sections.sections[value.second];
+					auto const &ring = *rings[section.ring];
+					for(std::size_t i = section.begin; i < section.end; ++i) {
+						if(passes(ring[i], ring[i + 1], p))
+							snaps.push_back(make_snap(section.ring, i, ring[i], ring[i + 1], p));
+					}
+				}));
+			}
+
+			std::sort(snaps.begin(), snaps.end(), [](snap const &a, snap const &b) {
+				return std::tie(a.ring, a.index, a.offset_1, a.offset_2) < std::tie(b.ring, b.index, b.offset_1, b.offset_2);
+			});
+			for(auto s = snaps.begin(); s != snaps.end(); ) {
+				std::size_t r = s->ring;
+				auto &ring = *rings[r];
+				ring_t snapped;
+				for(std::size_t i = 0; i < boost::size(ring); ++i) {
+					push_point(snapped, ring[i]);
+					for(; s != snaps.end() && s->ring == r && s->index == i; ++s)
+						push_point(snapped, s->p);
+				}
+				ring = std::move(snapped);
+			}
+		}
+	}
+
+private:
+	template<typename ring_t>
+	static inline void push_point(ring_t &ring, point_t const &p)
+	{
+		if(boost::empty(ring) || !boost::geometry::equals(ring.back(), p))
+			ring.push_back(p);
+	}
+
+	static inline double get_x(point_t const &p) { return double(boost::geometry::get<0>(p)); }
+	static inline double get_y(point_t const &p) { return double(boost::geometry::get<1>(p)); }
+
+	static inline snap make_snap(std::size_t ring, std::size_t index, point_t const &a, point_t const &b, point_t const &p)
+	{
+		std::int64_t dx = std::abs(std::int64_t(boost::geometry::get<0>(p)) - std::int64_t(boost::geometry::get<0>(a)));
+		std::int64_t dy = std::abs(std::int64_t(boost::geometry::get<1>(p)) - std::int64_t(boost::geometry::get<1>(a)));
+		bool along_x = std::abs(get_x(b) - get_x(a)) >= std::abs(get_y(b) - get_y(a));
+		return { ring, index, along_x ? dx : dy, along_x ? dy : dx, p };
+	}
+
+	// Point p, collinear with segment a-b, lies inside the segment
+	static inline bool inside(point_t const &p, point_t const &a, point_t const &b)
+	{
+		return !boost::geometry::equals(p, a) && !boost::geometry::equals(p, b)
+			&& std::min(get_x(a), get_x(b)) <= get_x(p) && get_x(p) <= std::max(get_x(a), get_x(b))
+			&& std::min(get_y(a), get_y(b)) <= get_y(p) && get_y(p) <= std::max(get_y(a), get_y(b));
+	}
+
+	// Add the pixels of the crossing of segments a-b and c-d. Where the segments touch or 
+	// overlap, the end points inside the other segment are added, so that segment is split.
+	void add_crossing(point_t const &a, point_t const &b, point_t const &c, point_t const &d)
+	{
+		if(std::max(get_x(a), get_x(b)) < std::min(get_x(c), get_x(d)) || std::max(get_x(c), get_x(d)) < std::min(get_x(a), get_x(b))
+			|| std::max(get_y(a), get_y(b)) < std::min(get_y(c), get_y(d)) || std::max(get_y(c), get_y(d)) < std::min(get_y(a), get_y(b)))
+			return;
+
+		double o1 = orientation::apply(get_x(a), get_y(a), get_x(b), get_y(b), get_x(c), get_y(c));
+		double o2 = orientation::apply(get_x(a), get_y(a), get_x(b), get_y(b), get_x(d), get_y(d));
+		if((o1 > 0 && o2 > 0) || (o1 < 0 && o2 < 0))
+			return;
+		double o3 = orientation::apply(get_x(c), get_y(c), get_x(d), get_y(d), get_x(a), get_y(a));
+		double o4 = orientation::apply(get_x(c), get_y(c), get_x(d), get_y(d), get_x(b), get_y(b));
+		if((o3 > 0 && o4 > 0) || (o3 < 0 && o4 < 0))
+			return;
+
+		if(o1 == 0 || o2 == 0 || o3 == 0 || o4 == 0) {
+			if(o1 == 0 && inside(c, a, b)) pixels.push_back(c);
+			if(o2 == 0 && inside(d, a, b)) pixels.push_back(d);
+			if(o3 == 0 && inside(a, c, d)) pixels.push_back(a);
+			if(o4 == 0 && inside(b, c, d)) pixels.push_back(b);
+			return;
+		}
+
+		double t = o3 / (o3 - o4);
+		double x = get_x(a) + t * (get_x(b) - get_x(a));
+		double y = get_y(a) + t * (get_y(b) - get_y(a));
+		double tolerance = pixel_tolerance * (1.0 + std::abs(x) + std::abs(y));
+		for(double px = std::floor(x + 0.5 - tolerance); px <= std::floor(x + 0.5 + tolerance); ++px) {
+			for(double py = std::floor(y + 0.5 - tolerance); py <= std::floor(y + 0.5 + tolerance); ++py) {
+				point_t p;
+				boost::geometry::set<0>(p, coordinate_t(px));
+				boost::geometry::set<1>(p, coordinate_t(py));
+				pixels.push_back(p);
+			}
+		}
+	}
+
+	// Segment a-b passes through the pixel of grid point p, other than at its end points. The 
+	// pixel is half open, it contains its left and bottom edge, so a segment touching pixels at 
+	// their shared corner passes through one of them only.
+	static inline bool passes(point_t const &a, point_t const &b, point_t const &p)
+	{
+		if(boost::geometry::equals(a, p) || boost::geometry::equals(b, p))
+			return false;
+
+		double x = get_x(p), y = get_y(p);
+		if(std::min(get_x(a), get_x(b)) > x || std::max(get_x(a), get_x(b)) < x 
+			|| std::min(get_y(a), get_y(b)) > y || std::max(get_y(a), get_y(b)) < y)
+			return false;
+
+		int above = 0, below = 0;
+		for(double cx: { x - 0.5, x + 0.5 }) {
+			for(double cy: { y - 0.5, y + 0.5 }) {
+				double o = orientation::apply(get_x(a), get_y(a), get_x(b), get_y(b), cx, cy);
+				above += o > 0;
+				below += o < 0;
+			}
+		}
+		if(above > 0 && below > 0)
+			return true;
+
+		// A segment between grid points can not run along an edge, it touches a single corner 
+		// when the others are on one side
+		return above + below == 3 && std::min(get_x(a), get_x(b)) < x && std::min(get_y(a), get_y(b)) < y
+			&& orientation::apply(get_x(a), get_y(a), get_x(b), get_y(b), x - 0.5, y - 0.5) == 0;
+	}
+};
+
+// Snap the outer and inners of a polygon together, so the corrected rings only meet at grid 
+// points. Rings with floating point coordinates are left as they are.
+template<typename polygon_t, typename point_t>
+static inline void snap_polygon(polygon_t &polygon, snap_rounding<point_t> &snap)
+{
+	typedef typename boost::geometry::ring_type<polygon_t>::type ring_t;
+	if(!std::is_integral<typename boost::geometry::coordinate_type<point_t>::type>::value)
+		return;
+
+	std::vector<ring_t *> rings;
+	rings.push_back(&polygon.outer());
+	for(auto &inner: polygon.inners())
+		rings.push_back(&inner);
+
+	// The segment back to the first point is snapped as well
+	for(auto *ring: rings) {
+		if(!boost::empty(*ring) && !boost::geometry::equals(ring->front(), ring->back()))
+			ring->push_back(ring->front());
+	}
+	snap.apply(rings);
+}
+
+// Planar arrangement of a snapped ring, of which the segments only meet at their end points. 
+// The ring is split into the rings bounding the regions of each winding number: level k > 0 
+// bounds the region wound at least k times, level k < 0 the region wound at least -k times 
+// in the opposite direction. As for the rings traced along the pseudo vertices, the winding 
+// number of a point is the sum of the rings around it counted by the sign of their area, but 
+// segments overlapping after snapping are merged instead of traced twice.
+template<typename point_t>
+struct ring_arrangement
+{
+	// Segment between vertices from < to, wound weight times from-to by the ring. Half edge 
+	// 2 e runs from-to and its twin 2 e + 1 runs to-from.
+	struct edge
+	{
+		std::size_t from;
+		std::size_t to;
+		std::ptrdiff_t weight;
+	};
+
+	static constexpr std::size_t none = std::size_t(-1);
+
+	std::pmr::vector<point_t> points;
+	std::pmr::vector<std::size_t> ids;
+	std::pmr::vector<edge> edges;
+
+	// Outgoing half edges by vertex in counterclockwise order, and the position of each half 
+	// edge in the order of its vertex
+	std::pmr::vector<std::size_t> offsets;
+	std::pmr::vector<std::size_t> outgoing;
+	std::pmr::vector<std::size_t> ranks;
+
+	// Face left of each half edge, and the winding number of each face
+	std::pmr::vector<std::size_t> faces;
+	std::pmr::vector<std::size_t> face_edges;
+	std::pmr::vector<std::ptrdiff_t> windings;
+	std::pmr::vector<std::size_t> stack;
+
+	// Half edges by level, and the traced vertices
+	std::pmr::vector<std::pair<std::ptrdiff_t, std::size_t>> levels;
+	std::pmr::vector<bool> in_level;
+	std::pmr::vector<std::size_t> positions;
+	std::pmr::vector<std::size_t> ring_points;
+
+	explicit ring_arrangement(std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+		: points(resource), ids(resource), edges(resource), offsets(resource), outgoing(resource), ranks(resource), 
+		faces(resource), face_edges(resource), windings(resource), stack(resource), levels(resource), 
+		in_level(resource), positions(resource), ring_points(resource)
+	{ }
+
+	// Rings of all levels with their area, rings with an area up to remove_spike_min_area are 
+	// counted in dropped_count
+	template<typename ring_t>
+	std::vector<std::pair<ring_t, double>> apply(ring_t const &ring, double remove_spike_min_area, std::size_t &dropped_count)
+	{
+		std::vector<std::pair<ring_t, double>> result;
+		build(ring);
+		trace_faces();
+
+		// Winding numbers count counterclockwise, the ring type counts its own orientation
+		bool clockwise = boost::geometry::point_order<ring_t>::value == boost::geometry::clockwise;
+
+		// A half edge bounds the levels between the winding numbers on its right and left
+		levels.clear();
+		for(std::size_t h = 0; h < faces.size(); ++h) {
+			std::ptrdiff_t left = windings[faces[h]], right = windings[faces[h ^ 1]];
+			if(clockwise) {
+				left = -left;
+				right = -right;
+			}
+			for(std::ptrdiff_t k = right + 1; k <= left; ++k)
+				levels.emplace_back(k >= 1 ? k : k - 1, h);
+		}
+		std::sort(levels.begin(), levels.end());
+
+		in_level.assign(faces.size(), false);
+		positions.assign(points.size(), none);
+		for(auto begin = levels.begin(); begin != levels.end(); ) {
+			auto end = begin;
+			for(; end != levels.end() && end->first == begin->first; ++end)
+				in_level[end->second] = true;
+
+			// Follow the boundary of the level with the region on the left, turning left as 
+			// far as possible, so regions touching at a vertex are traced apart
+			for(auto l = begin; l != end; ++l) {
+				std::size_t h = l->second;
+				if(!in_level[h])
+					continue;
+				ring_points.clear();
+				add_point(from(h), result, remove_spike_min_area, dropped_count);
+				while(in_level[h]) {
+					in_level[h] = false;
+					add_point(to(h), result, remove_spike_min_area, dropped_count);
+					h = next(h, [this](std::size_t g) { return in_level[g]; });
+				}
+				for(auto id: ring_points)
+					positions[id] = none;
+			}
+			begin = end;
+		}
+
+		if(clockwise) {
+			for(auto &r: result) {
+				std::reverse(r.first.begin(), r.first.end());
+				r.second = -r.second;
+			}
+		}
+		return result;
+	}
+
+private:
+	static inline double get_x(point_t const &p) { return double(boost::geometry::get<0>(p)); }
+	static inline double get_y(point_t const &p) { return double(boost::geometry::get<1>(p)); }
+
+	std::size_t from(std::size_t h) const { return h & 1 ? edges[h / 2].to : edges[h / 2].from; }
+	std::size_t to(std::size_t h) const { return h & 1 ? edges[h / 2].from : edges[h / 2].to; }
+	std::ptrdiff_t weight(std::size_t h) const { return h & 1 ? -edges[h / 2].weight : edges[h / 2].weight; }
+
+	// First half edge accepted by the filter, clockwise from the twin of half edge h
+	template<typename filter_t>
+	std::size_t next(std::size_t h, filter_t const &filter) const
+	{
+		std::size_t begin = offsets[to(h)];
+		std::size_t count = offsets[to(h) + 1] - begin;
+		std::size_t rank = ranks[h ^ 1];
+		for(std::size_t i = 1; i <= count; ++i) {
+			std::size_t g = outgoing[begin + (rank + count - i) % count];
+			if(filter(g))
+				return g;
+		}
+		return h ^ 1;
+	}
+
+	// Direction of half edge h lies in the upper half plane, or along the positive x axis
+	bool upper(std::size_t h) const
+	{
+		auto const &a = points[from(h)];
+		auto const &b = points[to(h)];
+		return get_y(b) > get_y(a) || (get_y(b) == get_y(a) && get_x(b) > get_x(a));
+	}
+
+	template<typename ring_t>
+	void build(ring_t const &ring)
+	{
+		points.assign(boost::begin(ring), boost::end(ring));
+		std::sort(points.begin(), points.end(), compare_point_less<point_t>());
+		points.erase(std::unique(points.begin(), points.end(), [](point_t const &a, point_t const &b) { 
+			return boost::geometry::equals(a, b); 
+		}), points.end());
+
+		ids.clear();
+		for(auto const &p: ring)
+			ids.push_back(std::lower_bound(points.begin(), points.end(), p, compare_point_less<point_t>()) - points.begin());
+
+		// Merge the segments between the same vertices
+		edges.clear();
+		for(std::size_t i = 0; i + 1 < ids.size(); ++i) {
+			std::size_t a = ids[i], b = ids[i + 1];
+			if(a != b)
+				edges.push_back(a < b ? edge{ a, b, 1 } : edge{ b, a, -1 });
+		}
+		std::sort(edges.begin(), edges.end(), [](edge const &a, edge const &b) { 
+			return std::tie(a.from, a.to) < std::tie(b.from, b.to); 
+		});
+		std::size_t count = 0;
+		for(auto const &e: edges) {
+			if(count > 0 && edges[count - 1].from == e.from && edges[count - 1].to == e.to)
+				edges[count - 1].weight += e.weight;
+			else
+				edges[count++] = e;
+		}
+		edges.resize(count);
+
+		// Sort the outgoing half edges of every vertex counterclockwise from the positive x axis
+		offsets.assign(points.size() + 1, 0);
+		for(std::size_t h = 0; h < 2 * edges.size(); ++h)
+			++offsets[from(h) + 1];
+		for(std::size_t v = 0; v < points.size(); ++v)
+			offsets[v + 1] += offsets[v];
+		outgoing.resize(2 * edges.size());
+		ranks.assign(points.size(), 0);
+		for(std::size_t h = 0; h < 2 * edges.size(); ++h)
+			outgoing[offsets[from(h)] + ranks[from(h)]++] = h;
+		for(std::size_t v = 0; v < points.size(); ++v) {
+			auto const &p = points[v];
+			std::sort(outgoing.begin() + offsets[v], outgoing.begin() + offsets[v + 1], [this, &p](std::size_t g, std::size_t h) {
+				bool upper_g = upper(g), upper_h = upper(h);
+				if(upper_g != upper_h)
+					return upper_g;
+				auto const &a = points[to(g)];
+				auto const &b = points[to(h)];
+				return orientation::apply(get_x(p), get_y(p), get_x(a), get_y(a), get_x(b), get_y(b)) > 0;
+			});
+		}
+		ranks.resize(2 * edges.size());
+		for(std::size_t v = 0; v < points.size(); ++v) {
+			for(std::size_t i = offsets[v]; i < offsets[v + 1]; ++i)
+				ranks[outgoing[i]] = i - offsets[v];
+		}
+	}
+
+	// Trace the faces left of the half edges. The ring is connected, so the faces are reached 
+	// from the outer face, which has the smallest area and winding number zero, by crossing 
+	// the edges.
+	void trace_faces()
+	{
+		faces.assign(2 * edges.size(), none);
+		face_edges.clear();
+		std::size_t outer = none;
+		double outer_area = 0;
+		for(std::size_t start = 0; start < faces.size(); ++start) {
+			if(faces[start] != none)
+				continue;
+			double area = 0;
+			std::size_t h = start;
+			do {
+				faces[h] = face_edges.size();
+				auto const &a = points[from(h)];
+				auto const &b = points[to(h)];
+				area += get_x(a) * get_y(b) - get_x(b) * get_y(a);
+				h = next(h, [](std::size_t) { return true; });
+			} while(h != start);
+			if(outer == none || area < outer_area) {
+				outer = face_edges.size();
+				outer_area = area;
+			}
+			face_edges.push_back(start);
+		}
+
+		std::ptrdiff_t const unknown = std::numeric_limits<std::ptrdiff_t>::max();
+		windings.assign(face_edges.size(), unknown);
+		stack.clear();
+		if(outer == none)
+			return;
+		windings[outer] = 0;
+		stack.push_back(outer);
+		while(!stack.empty()) {
+			std::size_t face = stack.back();
+			stack.pop_back();
+			std::size_t h = face_edges[face];
+			do {
+				std::size_t other = faces[h ^ 1];
+				if(windings[other] == unknown) {
+					windings[other] = windings[face] - weight(h);
+					stack.push_back(other);
+				}
+				h = next(h, [](std::size_t) { return true; });
+			} while(h != face_edges[face]);
+		}
+	}
+
+	// Add vertex v to the traced ring, a vertex visited before closes the ring since that visit
+	template<typename ring_t>
+	void add_point(std::size_t v, std::vector<std::pair<ring_t, double>> &result, double remove_spike_min_area, std::size_t &dropped_count)
+	{
+		std::size_t position = positions[v];
+		if(position == none) {
+			positions[v] = ring_points.size();
+			ring_points.push_back(v);
+			return;
+		}
+
+		ring_t new_ring;
+		for(std::size_t i = position; i < ring_points.size(); ++i) {
+			new_ring.push_back(points[ring_points[i]]);
+			if(i > position)
+				positions[ring_points[i]] = none;
+		}
+		new_ring.push_back(points[v]);
+		ring_points.resize(position + 1);
+
+		double area = boost::geometry::area(new_ring);
+		if(std::abs(area) > remove_spike_min_area)
+			result.push_back(std::make_pair(std::move(new_ring), area));
+		else
+			++dropped_count;
+	}
+};
+
+template<
+	typename point_t = boost::geometry::model::d2::point_xy<double>, 
+	typename ring_t = boost::geometry::model::ring<point_t>,
+	typename intersections_t
+	>
+static inline void dissolve_find_intersections(
+			ring_t const &ring,
+			pseudo_vertice_graph<point_t> &graph,
+			intersections_t const &find_intersections)
+{
+	if(ring.empty()) return;
+   
+	typedef typename pseudo_vertice_graph<point_t>::key_t key_t;
+	typedef segment_offset<point_t> offset;
+
+	auto &pseudo_vertices = graph.vertices;
+    for(std::size_t i = 0; i < ring.size(); ++i) {
+        pseudo_vertices.emplace_back(key_t(i, i, 0), ring[i]);       
+	}
+
+	// An intersection at the end point of a segment, up to rounding of the intersection point,
+	// is moved to the start of the next segment. The next segment does not always report it 
+	// itself, it can start on the other segment without crossing it. Other intersections beyond 
+	// the end of a segment are skipped.
+	typedef typename offset::type offset_t;
+	std::size_t segments = ring.size() - 1;
+	auto hand_over = [&](std::size_t &i, offset_t &offset_i, point_t const &p) {
+		auto length = offset::apply(ring[i], ring[i + 1], ring[i + 1]);
+		if(offset_i < length)
+			return true;
+		offset_t tolerance = 64 * std::numeric_limits<offset_t>::epsilon() * 
+			(std::abs(offset_t(boost::geometry::get<0>(ring[i + 1]))) + std::abs(offset_t(boost::geometry::get<1>(ring[i + 1]))));
+		if(boost::geometry::comparable_distance(p, ring[i + 1]) > tolerance * tolerance)
+			return false;
+		i = (i + 1) % segments;
+		offset_i = 0;
+		return true;
+	};
+
+	// Detect intersections
+	auto &intersections = graph.intersections;
+	find_intersections(ring, [&](std::size_t i, std::size_t j, point_t const &p) {
+		auto offset_1 = offset::apply(ring[i], ring[i + 1], p);
+		auto offset_2 = offset::apply(ring[j], ring[j + 1], p);
+
+		// The point between consecutive segments is not an intersection
+		if(!hand_over(i, offset_1, p) || !hand_over(j, offset_2, p) || i == j)
+			return;
+		if(i < j)
+			intersections.push_back({ i, j, offset_1, offset_2, p });
+		else
+			intersections.push_back({ j, i, offset_2, offset_1, p });
+	});
+
+	// Where the next segment reports a moved intersection as well, it is found twice, with 
+	// the point computed from different segments. Only the first is kept, otherwise the 
+	// by-passes of both would not link to each other.
+	typedef typename pseudo_vertice_graph<point_t>::intersection intersection;
+	std::sort(intersections.begin(), intersections.end(), [](intersection const &a, intersection const &b) {
+		return std::tie(a.index_1, a.index_2, a.offset_1) < std::tie(b.index_1, b.index_2, b.offset_1);
+	});
+	intersections.erase(std::unique(intersections.begin(), intersections.end(), [](intersection const &a, intersection const &b) {
+		return a.index_1 == b.index_1 && a.index_2 == b.index_2 && (a.offset_1 == b.offset_1 || a.offset_2 == b.offset_2);
+	}), intersections.end());
+
+	// Generate pseudo-vertices
+	for(auto const &intersection: intersections) {
+		std::size_t i = intersection.index_1, j = intersection.index_2;
+		key_t key_j(j, i, intersection.offset_2);
+		pseudo_vertices.emplace_back(key_t(i, j, intersection.offset_1, true), pseudo_vertice<point_t>(intersection.p, key_j));
+		pseudo_vertices.emplace_back(key_j, intersection.p);
+		graph.start_keys.push_back(key_j);
+
+		key_t key_i(i, j, intersection.offset_1);
+		pseudo_vertices.emplace_back(key_t(j, i, intersection.offset_2, true), pseudo_vertice<point_t>(intersection.p, key_i));
+		pseudo_vertices.emplace_back(key_i, intersection.p);
+		graph.start_keys.push_back(key_i);
+	}
+
+	graph.build();
+}
+
+template<
+	typename point_t = boost::geometry::model::d2::point_xy<double>, 
+	typename ring_t = boost::geometry::model::ring<point_t>
+	>
+static inline void dissolve_find_intersections(
+			ring_t const &ring,
+			pseudo_vertice_graph<point_t> &graph)
+{
+    std::vector<boost::geometry::detail::overlay::turn_info<point_t>> turns;
+	dissolve_find_intersections(ring, graph, self_turns_intersections<decltype(turns)>{ turns });
+}
+
+// Remove invalid points (NaN), and optionally repeated and collinear points, from 
+// the ring and close the ring. All points are moved at most once.
+template<
+	typename point_t = boost::geometry::model::d2::point_xy<double>, 
+	typename ring_t = boost::geometry::model::ring<point_t>
+	>
+static inline void correct_compact(ring_t &ring, bool remove_duplicates = false, bool remove_collinear = false)
+{
+	auto out = ring.begin();
+
+	// Remove previous points which lie on the segment to point p
+	auto remove_collinear_before = [&](auto const &p) {
+		while(remove_collinear && out - ring.begin() >= 2) {
+			auto const &a = *(out - 2);
+			auto const &b = *(out - 1);
+			double dx1 = boost::geometry::get<0>(b) - boost::geometry::get<0>(a);
+			double dy1 = boost::geometry::get<1>(b) - boost::geometry::get<1>(a);
+			double dx2 = boost::geometry::get<0>(p) - boost::geometry::get<0>(b);
+			double dy2 = boost::geometry::get<1>(p) - boost::geometry::get<1>(b);
+			if(dx1 * dy2 - dy1 * dx2 != 0 || dx1 * dx2 + dy1 * dy2 <= 0)
+				break;
+			--out;
+		}
+	};
+
+	for(auto i = ring.begin(); i != ring.end(); ++i) {
+		if(!boost::geometry::is_valid(*i))
+			continue;
+
+		if(remove_duplicates && out != ring.begin() && boost::geometry::equals(*i, *(out - 1)))
+			continue;
+
+		remove_collinear_before(*i);
+		if(out != i)
+			*out = std::move(*i);
+		++out;
+	}
+
+	// Close ring if not closed
+	if(out != ring.begin() && !boost::geometry::equals(*(out - 1), ring.front())) {
+		remove_collinear_before(ring.front());
+		if(out == ring.end()) {
+			ring.push_back(ring.front());
+			return;
+		}
+		*out++ = ring.front();
+	}
+
+	ring.erase(out, ring.end());
+}
+
+// Correct orientation of ring
+template<
+	typename point_t = boost::geometry::model::d2::point_xy<double>, 
+	typename ring_t = boost::geometry::model::ring<point_t>
+	>
+static inline double correct_orientation(ring_t &ring, boost::geometry::order_selector order)
+{
+	auto area = boost::geometry::area(ring);
+	bool should_reverse =
+		(order == boost::geometry::clockwise && area < 0) ||
+		(order == boost::geometry::counterclockwise && area > 0);
+
+	if(should_reverse) {
+		std::reverse(ring.begin(), ring.end());
+	} 
+
+	return area;
+}
+
+template<
+	typename point_t = boost::geometry::model::d2::point_xy<double>, 
+	typename ring_t = boost::geometry::model::ring<point_t>
+	>
+static inline std::vector<std::pair<ring_t, double>> dissolve_generate_rings(
+			pseudo_vertice_graph<point_t> &graph,
+			boost::geometry::order_selector order, double remove_spike_min_area = 0.0)
+{
+	std::vector<std::pair<ring_t,double>> result;
+
+	auto const &pseudo_vertices = graph.vertices;
+	auto &visited = graph.visited;
+	visited.assign(pseudo_vertices.size(), false);
+
+	// Next start vertex which is not yet visited, in key order
+	std::size_t next_start = 0;
+	auto find_start = [&pseudo_vertices, &visited, &next_start]() {
+		while(next_start < pseudo_vertices.size() && (!pseudo_vertices[next_start].second.start || visited[next_start]))
+			++next_start;
+		return next_start < pseudo_vertices.size();
+	};
+
+	// Position of the start points in the traced ring, by point id
+	std::size_t const none = std::size_t(-1);
+	auto &positions = graph.positions;
+	auto &ring_points = graph.ring_points;
+	positions.assign(graph.point_count, none);
+
+	// Generate all polygons by tracing all the intersections
+	// Perform union to combine all polygons into single polygon again
+    while(find_start()) {    
+		ring_t new_ring;
+		ring_points.clear();
+
+		// Store point in generated polygon
+		auto push_point = [&new_ring, &ring_points](pseudo_vertice<point_t> const &vertice) { 
+            if(new_ring.empty() || boost::geometry::comparable_distance(new_ring.back(), vertice.p) > 0) {
+                new_ring.push_back(vertice.p);
+				ring_points.push_back(vertice.point_id);
+			}
+		};
+
+		// Store newly generated ring
+		auto push_ring = [&result, &graph, remove_spike_min_area](ring_t &new_ring) {
+			auto area = boost::geometry::area(new_ring);
+			if(std::abs(area) > remove_spike_min_area) {
+		    	result.push_back(std::make_pair(std::move(new_ring), area));
+			} else {
+				++graph.dropped_count;
+			}
+		};
+
+        std::size_t i = next_start;
+		positions[pseudo_vertices[i].second.point_id] = 0;
+
+        while(true) {
+            auto const &key = pseudo_vertices[i].first;
+            auto const &value = pseudo_vertices[i].second;
+        
+			// Store the point in output polygon
+			push_point(value);
+            
+			// Mark the vertex as visited
+			visited[i] = true;
+
+			// Back at a start point of this ring, the outer ring is closed or an inner ring is split off
+			std::size_t position = positions[value.point_id];
+			if(position != none && position + 1 < new_ring.size() && ring_points[position] == value.point_id) {
+				if(position == 0)
+					break;
+
+				// Copy the new inner ring
+				ring_t inner_ring(new_ring.begin() + position, new_ring.end());
+				push_ring(inner_ring);
+
+				// Remove the inner ring
+				for(std::size_t k = position; k < ring_points.size(); ++k) {
+					if(positions[ring_points[k]] >= position)
+						positions[ring_points[k]] = none;
+				}
+				new_ring.erase(new_ring.begin() + position, new_ring.end());
+				ring_points.resize(position);
+			} else if(value.start) {
+				// Store possible new inner ring starting point
+				positions[value.point_id] = new_ring.size() - 1;
+			}
+
+            if(key.reroute) {
+				// Follow by-pass
+                i = value.link_index;
+			} else {
+				// Continu following original polygon
+                ++i;
+                if(i == pseudo_vertices.size())
+                    i = 0;
+            }
+		}
+
+		for(auto id: ring_points)
+			positions[id] = none;
+
+		// Combine with already generated polygons
+		push_ring(new_ring);
+   	}
+
+    return result;
+}
+
+// Buffers used for correcting a ring. These keep their capacity, so they can be 
+// reused for many corrections. All buffers except the ring are allocated from 
+// the memory resource.
+template<
+	typename point_t = boost::geometry::model::d2::point_xy<double>, 
+	typename ring_t = boost::geometry::model::ring<point_t>,
+	typename statistics_t = no_statistics
+	>
+struct correct_workspace
+{
+	ring_t ring;
+	pseudo_vertice_graph<point_t> graph;
+	std::pmr::vector<boost::geometry::detail::overlay::turn_info<point_t>> turns;
+	std::pmr::vector<sweep_segment> segments;
+	sweep_active active;
+	section_index<point_t> sections;
+	snap_rounding<point_t> snap;
+	ring_arrangement<point_t> arrangement;
+
+	// Method used to find the self intersections of the rings. The sweep and sections do not yet 
+	// give the same result as self_turns on nearly collinear rings.
+	intersection_method method = intersection_method::self_turns;
+
+	// Remove repeated and collinear points before searching for self intersections
+	bool remove_duplicates = true;
+	bool remove_collinear = false;
+
+	// Statistics of the corrections using this workspace
+	statistics_t statistics;
+
+	explicit correct_workspace(std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+		: graph(resource), turns(resource), segments(resource), active(resource), sections(resource), 
+		snap(resource), arrangement(resource)
+	{ }
+};
+
+// Workspace for the rings of a ring, polygon or multi polygon
+template<typename geometry_t, typename statistics_t = no_statistics>
+using correct_workspace_t = correct_workspace<typename boost::geometry::point_type<geometry_t>::type, typename boost::geometry::ring_type<geometry_t>::type, statistics_t>;
+
+template<
+	typename point_t = boost::geometry::model::d2::point_xy<double>, 
+	typename polygon_t = boost::geometry::model::polygon<point_t>,
+	typename ring_t = boost::geometry::model::ring<point_t>,
+	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>,
+	typename statistics_t = no_statistics
+	>
+static inline std::vector<std::pair<ring_t, double>> correct_inplace(ring_t &ring, boost::geometry::order_selector order, double remove_spike_min_area, correct_workspace<point_t, ring_t, statistics_t> &workspace)
+{
+	constexpr std::size_t min_nodes = 3;
+	if(ring.size() < min_nodes)
+		return { };
+
+	auto &graph = workspace.graph;
+	auto &statistics = workspace.statistics;
+	graph.clear();
+
+	{
+		stage_timer<statistics_t> timer(statistics, correct_stage::compact);
+
+		// Remove invalid coordinates and close ring
+		correct_compact(ring, workspace.remove_duplicates, workspace.remove_collinear);
+
+		// Correct orientation
+		correct_orientation(ring, order);
+	}
+
+	// Route the segments through the grid points of their crossings and split the ring along 
+	// the arrangement of the snapped segments
+	if(std::is_integral<typename boost::geometry::coordinate_type<point_t>::type>::value) {
+		bool snapped;
+		{
+			stage_timer<statistics_t> timer(statistics, correct_stage::intersections);
+			ring_t *rings[] = { &ring };
+			snapped = workspace.snap.apply(rings);
+		}
+		if(snapped) {
+			stage_timer<statistics_t> timer(statistics, correct_stage::trace);
+			std::size_t dropped_count = 0;
+			auto result = workspace.arrangement.apply(ring, remove_spike_min_area, dropped_count);
+			statistics.add_ring(ring.size(), 0, workspace.arrangement.points.size(), result.size() + dropped_count, dropped_count);
+			return result;
+		}
+	}
+
+	{
+		stage_timer<statistics_t> timer(statistics, correct_stage::intersections);
+
+		// Detect self-intersection points
+		if(workspace.method == intersection_method::self_turns)
+			dissolve_find_intersections(ring, graph, self_turns_intersections<decltype(workspace.turns)>{ workspace.turns });
+		else if(workspace.method == intersection_method::sections)
+			dissolve_find_intersections(ring, graph, section_intersections<decltype(workspace.sections)>{ workspace.sections });
+		else
+			dissolve_find_intersections(ring, graph, sweep_intersections<decltype(workspace.segments)>{ workspace.segments, workspace.active });
+	}
+
+	if(graph.start_count == 0) {
+		double area = boost::geometry::area(ring);
+		bool keep = std::abs(area) > remove_spike_min_area;
+		statistics.add_ring(ring.size(), 0, 0, 0, keep ? 0 : 1);
+		if(keep)
+			return { std::make_pair(std::move(ring), area) };
+		else
+			return { };
+	}
+
+	stage_timer<statistics_t> timer(statistics, correct_stage::trace);
+	auto result = dissolve_generate_rings<point_t, ring_t>(graph, order, remove_spike_min_area);
+	statistics.add_ring(ring.size(), graph.start_keys.size() / 2, graph.vertices.size(), result.size() + graph.dropped_count, graph.dropped_count);
+	return result;
+}
+
+template<
+	typename point_t = boost::geometry::model::d2::point_xy<double>, 
+	typename polygon_t = boost::geometry::model::polygon<point_t>,
+	typename ring_t = boost::geometry::model::ring<point_t>,
+	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>,
+	typename statistics_t = no_statistics
+	>
+static inline std::vector<std::pair<ring_t, double>> correct(ring_t const &ring, boost::geometry::order_selector order, double remove_spike_min_area, correct_workspace<point_t, ring_t, statistics_t> &workspace)
+{
+	constexpr std::size_t min_nodes = 3;
+	if(ring.size() < min_nodes)
+		return { };
+
+	// Correct a copy of the ring in the buffer of the workspace
+	auto &new_ring = workspace.ring;
+	new_ring.assign(boost::begin(ring), boost::end(ring));
+	return correct_inplace<point_t, polygon_t, ring_t, multi_polygon_t>(new_ring, order, remove_spike_min_area, workspace);
+}
+
+template<
+	typename point_t = boost::geometry::model::d2::point_xy<double>, 
+	typename polygon_t = boost::geometry::model::polygon<point_t>,
+	typename ring_t = boost::geometry::model::ring<point_t>,
+	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>
+	>
+static inline std::vector<std::pair<ring_t, double>> correct(ring_t const &ring, boost::geometry::order_selector order, double remove_spike_min_area = 0.0)
+{
+	correct_workspace_t<ring_t> workspace;
+	return correct<typename boost::geometry::point_type<ring_t>::type, polygon_t, ring_t, multi_polygon_t>(ring, order, remove_spike_min_area, workspace);
+}
+
+template<
+	typename point_t = boost::geometry::model::d2::point_xy<double>, 
+	typename polygon_t = boost::geometry::model::polygon<point_t>,
+	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>
+	>
+static inline void fill_normalize_polygons(std::vector<std::pair<multi_polygon_t,double>> &input)
+{
+	for(auto &i: input) {
+		for(auto &poly: i.first) {
+			if(i.second < 0) {
+				std::reverse(poly.outer().begin(), poly.outer().end());
+			}
+		}
+	}
+}
+
+// Point in the interior of a simple ring. The point is halfway the widest part of the ring on 
+// the horizontal line halfway the largest gap between the y coordinates of the vertices, so it 
+// is not close to the boundary, also for long and thin rings.
+template<typename ring_t>
+static inline std::pair<double, double> fill_interior_point(ring_t const &ring)
+{
+	std::vector<double> ys;
+	ys.reserve(boost::size(ring));
+	for(auto const &p: ring)
+		ys.push_back(double(boost::geometry::get<1>(p)));
+	std::sort(ys.begin(), ys.end());
+
+	double y = ys.empty() ? 0.0 : ys.front(), gap = 0.0;
+	for(std::size_t i = 0; i + 1 < ys.size(); ++i) {
+		if(ys[i + 1] - ys[i] > gap) {
+			gap = ys[i + 1] - ys[i];
+			y = (ys[i] + ys[i + 1]) / 2;
+		}
+	}
+
+	std::vector<double> xs;
+	for(std::size_t i = 0; i + 1 < boost::size(ring); ++i) {
+		double ax = double(boost::geometry::get<0>(ring[i])), ay = double(boost::geometry::get<1>(ring[i]));
+		double bx = double(boost::geometry::get<0>(ring[i + 1])), by = double(boost::geometry::get<1>(ring[i + 1]));
+		if((ay < y) != (by < y))
+			xs.push_back(ax + (y - ay) * (bx - ax) / (by - ay));
+	}
+	std::sort(xs.begin(), xs.end());
+
+	double x = xs.empty() ? 0.0 : xs.front(), width = -1.0;
+	for(std::size_t i = 0; i + 1 < xs.size(); i += 2) {
+		if(xs[i + 1] - xs[i] > width) {
+			width = xs[i + 1] - xs[i];
+			x = (xs[i] + xs[i + 1]) / 2;
+		}
+	}
+	return std::make_pair(x, y);
+}
+
+// Check if the point is inside the simple ring, by counting the crossings of a horizontal ray
+template<typename ring_t>
+static inline bool fill_ring_contains(ring_t const &ring, std::pair<double, double> const &p)
+{
+	bool inside = false;
+	for(std::size_t i = 0; i + 1 < boost::size(ring); ++i) {
+		double ax = double(boost::geometry::get<0>(ring[i])), ay = double(boost::geometry::get<1>(ring[i]));
+		double bx = double(boost::geometry::get<0>(ring[i + 1])), by = double(boost::geometry::get<1>(ring[i + 1]));
+		if((ay < p.second) != (by < p.second) && p.first < ax + (p.second - ay) * (bx - ax) / (by - ay))
+			inside = !inside;
+	}
+	return inside;
+}
+
+// Call visit(i, j) for every ring i which covers ring j, with i < j. The rings are sorted on 
+// decreasing area and do not cross, so a ring is covered by a larger ring when a point in its 
+// interior is. Candidate larger rings are found by their envelope.
+template<
+	typename point_t = boost::geometry::model::d2::point_xy<double>, 
+	typename multi_polygon_t,
+	typename visitor_t
+	>
+static inline void fill_containment(std::vector<std::pair<multi_polygon_t, double>> const &input, visitor_t const &visit)
+{
+	typedef boost::geometry::model::box<point_t> box_t;
+	typedef std::pair<box_t, std::size_t> value_t;
+
+	std::vector<value_t> envelopes;
+	envelopes.reserve(input.size());
+	for(std::size_t i = 0; i < input.size(); ++i)
+		envelopes.emplace_back(boost::geometry::return_envelope<box_t>(input[i].first), i);
+
+	boost::geometry::index::rtree<value_t, boost::geometry::index::rstar<16>> index(envelopes);
+
+	std::vector<value_t> candidates;
+	for(std::size_t j = 1; j < input.size(); ++j) {
+		candidates.clear();
+		index.query(boost::geometry::index::covers(envelopes[j].first), std::back_inserter(candidates));
+
+		std::pair<double, double> interior;
+		bool has_interior = false;
+		for(auto const &candidate: candidates) {
+			std::size_t i = candidate.second;
+			if(i >= j || boost::empty(input[j].first))
+				continue;
+
+			if(!has_interior) {
+				interior = fill_interior_point(input[j].first.front().outer());
+				has_interior = true;
+			}
+
+			for(auto const &poly: input[i].first) {
+				if(fill_ring_contains(poly.outer(), interior)) {
+					visit(i, j);
+					break;
+				}
+			}
+		}
+	}
+}
+
+template<
+	typename point_t = boost::geometry::model::d2::point_xy<double>, 
+	typename polygon_t = boost::geometry::model::polygon<point_t>,
+	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>
+	>
+struct fill_non_zero_winding
+{
+	inline void operator()(std::vector<std::pair<multi_polygon_t, double>> &input) const
+	{
+		auto compare = [](std::pair<multi_polygon_t, double> const &a, std::pair<multi_polygon_t, double> const &b) { return std::abs(a.second) > std::abs(b.second); };
+		std::sort(input.begin(), input.end(), compare);
+
+		std::vector<int> scores;
+		for(auto &mp: input) {
+			scores.push_back(mp.second > 0 ? 1 : -1);
+		}
+
+		fill_normalize_polygons(input);
+
+		fill_containment<point_t>(input, [&scores](std::size_t i, std::size_t j) {
+			scores[j] += scores[i];
+		});
+
+		result_combine_index<multi_polygon_t> outers;
+		result_combine_index<multi_polygon_t> inners;
+
+		for(std::size_t i = 0; i < input.size(); ++i) {
+			if(scores[i] != 0)
+				outers.insert_multiple(input[i].first);
+			else
+				inners.insert_multiple(input[i].first);
+		}
+
+		multi_polygon_t combined_outers;
+		multi_polygon_t combined_inners;
+		outers.release(combined_outers);
+		inners.release(combined_inners);
+
+		multi_polygon_t output;
+		boost::geometry::difference(combined_outers, combined_inners, output);
+
+		input.resize(1);
+		input.front().first = std::move(output);
+	}
+};
+
+template<typename point_t>
+struct fill_edge
+{
+	point_t from;
+	point_t to;
+	int weight;
+};
+
+// Split a closed ring at the vertices it passes more than once, every closed part 
+// is passed to visit as a separate ring.
+template<
+	typename point_t = boost::geometry::model::d2::point_xy<double>, 
+	typename ring_t = boost::geometry::model::ring<point_t>,
+	typename visitor_t
+	>
+static inline void fill_split_ring(ring_t const &ring, visitor_t const &visit)
+{
+	std::map<point_t, std::size_t, compare_point_less<point_t>> positions;
+	ring_t path;
+	for(auto const &p: ring) {
+		auto position = positions.find(p);
+		if(position == positions.end()) {
+			positions.emplace(p, path.size());
+			path.push_back(p);
+			continue;
+		}
+
+		auto first = path.begin() + position->second;
+		ring_t part(first, path.end());
+		part.push_back(p);
+		for(auto i = first + 1; i != path.end(); ++i)
+			positions.erase(*i);
+		path.erase(first + 1, path.end());
+		visit(std::move(part));
+	}
+}
+
+// Add the edges of the ring with weight, each edge stored from the lowest to the highest point
+template<
+	typename point_t = boost::geometry::model::d2::point_xy<double>, 
+	typename ring_t = boost::geometry::model::ring<point_t>
+	>
+static inline void fill_add_edges(ring_t const &ring, int weight, std::vector<fill_edge<point_t>> &edges)
+{
+	compare_point_less<point_t> less;
+	for(std::size_t k = 0; k + 1 < boost::size(ring); ++k) {
+		if(less(ring[k], ring[k + 1]))
+			edges.push_back({ ring[k], ring[k + 1], weight });
+		else if(less(ring[k + 1], ring[k]))
+			edges.push_back({ ring[k + 1], ring[k], -weight });
+	}
+}
+
+// Assemble the output polygons from weighted edges. Shared edges with opposite direction 
+// cancel out and the remaining edges are chained into rings.
+template<
+	typename point_t = boost::geometry::model::d2::point_xy<double>, 
+	typename polygon_t = boost::geometry::model::polygon<point_t>,
+	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>
+	>
+static inline void fill_assemble_edges(std::vector<fill_edge<point_t>> &edges, multi_polygon_t &output)
+{
+	typedef typename boost::geometry::ring_type<polygon_t>::type ring_t;
+	compare_point_less<point_t> less;
+
+	auto compare_edge = [&less](fill_edge<point_t> const &a, fill_edge<point_t> const &b) {
+		if(less(a.from, b.from)) return true;
+		if(less(b.from, a.from)) return false;
+		return less(a.to, b.to);
+	};
+	std::sort(edges.begin(), edges.end(), compare_edge);
+
+	// Cancel edges in opposite direction and direct the remaining edges
+	std::vector<std::pair<point_t, point_t>> directed;
+	for(std::size_t i = 0; i < edges.size(); ) {
+		int weight = 0;
+		std::size_t j = i;
+		for(; j < edges.size() && !compare_edge(edges[i], edges[j]); ++j)
+			weight += edges[j].weight;
+
+		for(int k = 0; k < std::abs(weight); ++k) {
+			if(weight > 0)
+				directed.emplace_back(edges[i].from, edges[i].to);
+			else
+				directed.emplace_back(edges[i].to, edges[i].from);
+		}
+
+		i = j;
+	}
+
+	std::sort(directed.begin(), directed.end(), 
+		[&less](std::pair<point_t, point_t> const &a, std::pair<point_t, point_t> const &b) { return less(a.first, b.first); });
+
+	// Chain the edges into rings. The filled area is on the right of clockwise rings, at a vertex 
+	// with multiple outgoing edges the edge turning sharpest towards the filled area is taken, 
+	// so rings touching in a vertex are split into separate rings.
+	bool filled_right = boost::geometry::point_order<polygon_t>::value == boost::geometry::clockwise;
+	std::vector<bool> used(directed.size(), false);
+
+	std::vector<std::pair<ring_t, double>> outers;
+	std::vector<std::pair<ring_t, double>> inners;
+
+	for(std::size_t start = 0; start < directed.size(); ++start) {
+		if(used[start])
+			continue;
+
+		ring_t ring;
+		ring.push_back(directed[start].first);
+		used[start] = true;
+
+		std::size_t current = start;
+		while(true) {
+			point_t const &from = directed[current].first;
+			point_t const &v = directed[current].second;
+			ring.push_back(v);
+
+			auto range = std::equal_range(directed.begin(), directed.end(), std::make_pair(v, v), 
+				[&less](std::pair<point_t, point_t> const &a, std::pair<point_t, point_t> const &b) { return less(a.first, b.first); });
+
+			// Angle counter clockwise from the incoming edge back to the outgoing edge
+			double back_x = boost::geometry::get<0>(from) - boost::geometry::get<0>(v);
+			double back_y = boost::geometry::get<1>(from) - boost::geometry::get<1>(v);
+
+			std::size_t next = directed.size();
+			double next_angle = 0.0;
+			for(auto i = range.first; i != range.second; ++i) {
+				std::size_t k = i - directed.begin();
+				if(used[k] && k != start)
+					continue;
+
+				double out_x = boost::geometry::get<0>(i->second) - boost::geometry::get<0>(v);
+				double out_y = boost::geometry::get<1>(i->second) - boost::geometry::get<1>(v);
+				double angle = std::atan2(back_x * out_y - back_y * out_x, back_x * out_x + back_y * out_y);
+				if(angle <= 0)
+					angle += 2 * boost::math::constants::pi<double>();
+
+				if(next == directed.size() || (filled_right ? angle < next_angle : angle > next_angle)) {
+					next = k;
+					next_angle = angle;
+				}
+			}
+
+			if(next == directed.size() || next == start)
+				break;
+
+			used[next] = true;
+			current = next;
+		}
+
+		if(!boost::geometry::equals(ring.back(), ring.front()))
+			ring.push_back(ring.front());
+
+		// Edges of different rings chained in a straight line leave collinear vertices
+		fill_split_ring<point_t>(ring, [&outers, &inners](ring_t &&part) {
+			correct_compact(part, false, true);
+			double area = boost::geometry::area(part);
+			if(area > 0)
+				outers.emplace_back(std::move(part), area);
+			else if(area < 0)
+				inners.emplace_back(std::move(part), area);
+		});
+	}
+
+	// Every inner belongs to the smallest outer, larger than the inner, in which it lies
+	std::sort(outers.begin(), outers.end(), 
+		[](std::pair<ring_t, double> const &a, std::pair<ring_t, double> const &b) { return a.second < b.second; });
+
+	std::size_t first = output.size();
+	for(auto &outer: outers) {
+		polygon_t poly;
+		poly.outer() = std::move(outer.first);
+		output.push_back(std::move(poly));
+	}
+
+	for(auto &inner: inners) {
+		std::pair<double, double> interior = fill_interior_point(inner.first);
+		for(std::size_t i = 0; i < outers.size(); ++i) {
+			if(outers[i].second > -inner.second && fill_ring_contains(output[first + i].outer(), interior)) {
+				output[first + i].inners().push_back(std::move(inner.first));
+				break;
+			}
+		}
+	}
+}
+
+// Assemble the output polygons from the boundary of the filled faces. A face is the area 
+// inside a ring but outside its child rings. Every ring is added with the difference between 
+// its face and the face of its parent.
+template<
+	typename point_t = boost::geometry::model::d2::point_xy<double>, 
+	typename polygon_t = boost::geometry::model::polygon<point_t>,
+	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>
+	>
+static inline void fill_assemble(std::vector<std::pair<multi_polygon_t, double>> const &input, std::vector<std::ptrdiff_t> const &parent, std::vector<bool> const &filled, multi_polygon_t &output)
+{
+	std::vector<fill_edge<point_t>> edges;
+	for(std::size_t j = 0; j < input.size(); ++j) {
+		int weight = int(filled[j]) - (parent[j] >= 0 ? int(filled[parent[j]]) : 0);
+		if(weight == 0)
+			continue;
+
+		for(auto const &poly: input[j].first)
+			fill_add_edges<point_t>(poly.outer(), weight, edges);
+	}
+
+	fill_assemble_edges<point_t, polygon_t, multi_polygon_t>(edges, output);
+}
+
+// Fill the rings with the non-zero winding rule, the winding number of every face follows 
+// from the signed area of its ring and the winding number of its parent. The output is 
+// assembled from the rings without any boolean operations.
+template<
+	typename point_t = boost::geometry::model::d2::point_xy<double>, 
+	typename polygon_t = boost::geometry::model::polygon<point_t>,
+	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>
+	>
+struct fill_non_zero_winding_direct
+{
+	inline void operator()(std::vector<std::pair<multi_polygon_t, double>> &input) const
+	{
+		auto compare = [](std::pair<multi_polygon_t, double> const &a, std::pair<multi_polygon_t, double> const &b) { return std::abs(a.second) > std::abs(b.second); };
+		std::sort(input.begin(), input.end(), compare);
+
+		std::vector<int> winding;
+		for(auto &mp: input) {
+			winding.push_back(mp.second > 0 ? 1 : -1);
+		}
+
+		fill_normalize_polygons(input);
+
+		// The parent of a ring is the smallest ring covering it
+		std::vector<std::ptrdiff_t> parent(input.size(), -1);
+		fill_containment<point_t>(input, [&parent](std::size_t i, std::size_t j) {
+			parent[j] = std::max(parent[j], std::ptrdiff_t(i));
+		});
+
+		std::vector<bool> filled(input.size());
+		for(std::size_t j = 0; j < input.size(); ++j) {
+			if(parent[j] >= 0)
+				winding[j] += winding[parent[j]];
+			filled[j] = winding[j] != 0;
+		}
+
+		multi_polygon_t output;
+		fill_assemble<point_t, polygon_t, multi_polygon_t>(input, parent, filled, output);
+
+		input.resize(1);
+		input.front().first = std::move(output);
+	}
+};
+
+// Fill the rings with the odd-even rule, the nesting depth of every face follows from the 
+// ring containing it. The output is assembled from the rings without any boolean operations.
+template<
+	typename point_t = boost::geometry::model::d2::point_xy<double>, 
+	typename polygon_t = boost::geometry::model::polygon<point_t>,
+	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>
+	>
+struct fill_odd_even
+{
+	inline void operator()(std::vector<std::pair<multi_polygon_t, double>> &input) const
+	{
+		auto compare = [](std::pair<multi_polygon_t, double> const &a, std::pair<multi_polygon_t, double> const &b) { return std::abs(a.second) > std::abs(b.second); };
+		std::sort(input.begin(), input.end(), compare);
+
+		fill_normalize_polygons(input);
+
+		// The parent of a ring is the smallest ring covering it
+		std::vector<std::ptrdiff_t> parent(input.size(), -1);
+		fill_containment<point_t>(input, [&parent](std::size_t i, std::size_t j) {
+			parent[j] = std::max(parent[j], std::ptrdiff_t(i));
+		});
+
+		// A face is filled when it is nested in an odd number of rings
+		std::vector<std::size_t> depth(input.size(), 1);
+		std::vector<bool> filled(input.size());
+		for(std::size_t j = 0; j < input.size(); ++j) {
+			if(parent[j] >= 0)
+				depth[j] += depth[parent[j]];
+			filled[j] = depth[j] % 2 == 1;
+		}
+
+		multi_polygon_t output;
+		fill_assemble<point_t, polygon_t, multi_polygon_t>(input, parent, filled, output);
+
+		input.resize(1);
+		input.front().first = std::move(output);
+	}
+};
+ 
+// Combine all parts into the output. Parts are combined pairwise, level by level, 
+// instead of one by one into a single growing result.
+template<typename combine_function_t, typename multi_polygon_t>
+static inline void combine_reduce(std::vector<multi_polygon_t> &parts, multi_polygon_t &output, combine_function_t const &combine)
+{
+	for(std::size_t step = 1; step < parts.size(); step *= 2) {
+		for(std::size_t i = 0; i + step < parts.size(); i += 2 * step)
+			combine(parts[i], parts[i + step]);
+	}
+
+	if(!parts.empty())
+		combine(output, parts.front());
+}
+
+template<typename combine_function_t, typename multi_polygon_t>
+static inline void combine_reduce(std::vector<multi_polygon_t> &parts, multi_polygon_t &output, combine_function_t const &combine, thread_pool &pool)
+{
+	// Same pairs as the serial reduce, the pairs of a level are combined concurrently
+	for(std::size_t step = 1; step < parts.size(); step *= 2) {
+		std::size_t pairs = (parts.size() - step + 2 * step - 1) / (2 * step);
+		pool.parallel_for(pairs, [&parts, &combine, step](std::size_t k) {
+			combine(parts[2 * step * k], parts[2 * step * k + step]);
+		});
+	}
+
+	if(!parts.empty())
+		combine(output, parts.front());
+}
+
+// Interrupt the search for turns at the first turn found
+struct turn_found_policy
+{
+	static bool const enabled = true;
+	bool has_intersections = false;
+
+	template<typename range_t>
+	inline bool apply(range_t const &range)
+	{
+		has_intersections = has_intersections || !boost::empty(range);
+		return has_intersections;
+	}
+};
+
+// Check if any segment of the geometry crosses or touches another segment of the geometry
+template<typename geometry_t>
+static inline bool has_self_turns(geometry_t const &geometry)
+{
+	typedef typename boost::geometry::point_type<geometry_t>::type point_t;
+
+	boost::geometry::strategies::cartesian<> strategy;
+	typedef boost::geometry::detail::no_rescale_policy rescale_policy_type;
+	std::vector<boost::geometry::detail::overlay::turn_info<point_t>> turns;
+
+	rescale_policy_type rescale_policy;
+	turn_found_policy policy;
+	boost::geometry::self_turns
+		<
+			boost::geometry::detail::overlay::assign_null_policy
+		>(geometry, strategy, rescale_policy, turns, policy);
+
+	return policy.has_intersections;
+}
+
+// Check if the ring is closed, has no invalid coordinates, repeated points or spikes, and 
+// has the orientation given by the sign of its area. A ring with an area smaller than 
+// remove_spike_min_area would be removed by the correction.
+template<typename ring_t>
+static inline bool is_valid_ring(ring_t const &ring, double sign, double remove_spike_min_area)
+{
+	constexpr std::size_t min_nodes = 4;
+	if(boost::size(ring) < min_nodes)
+		return false;
+
+	for(auto const &p: ring) {
+		if(!boost::geometry::is_valid(p))
+			return false;
+	}
+
+	if(!boost::geometry::equals(ring.front(), ring.back()))
+		return false;
+
+	for(std::size_t i = 1; i < boost::size(ring); ++i) {
+		auto const &a = ring[i - 1];
+		auto const &b = ring[i];
+		auto const &c = i + 1 < boost::size(ring) ? ring[i + 1] : ring[1];
+
+		double dx1 = boost::geometry::get<0>(b) - boost::geometry::get<0>(a);
+		double dy1 = boost::geometry::get<1>(b) - boost::geometry::get<1>(a);
+		double dx2 = boost::geometry::get<0>(c) - boost::geometry::get<0>(b);
+		double dy2 = boost::geometry::get<1>(c) - boost::geometry::get<1>(b);
+
+		// Repeated point, or a spike where the ring turns back on itself
+		if(dx1 == 0 && dy1 == 0)
+			return false;
+		if(dx1 * dy2 - dy1 * dx2 == 0 && dx1 * dx2 + dy1 * dy2 < 0)
+			return false;
+	}
+
+	double area = sign * boost::geometry::area(ring);
+	return area > 0 && area > remove_spike_min_area;
+}
+
+// Check if rings, of which no segments cross or touch, are not inside each other
+template<typename ring_range_t>
+static inline bool rings_disjoint(ring_range_t const &rings)
+{
+	typedef typename boost::range_value<ring_range_t>::type ring_t;
+	typedef typename boost::geometry::point_type<ring_t>::type point_t;
+	typedef boost::geometry::model::box<point_t> box_t;
+	typedef std::pair<box_t, std::size_t> value_t;
+
+	std::vector<value_t> envelopes;
+	envelopes.reserve(boost::size(rings));
+	for(std::size_t i = 0; i < boost::size(rings); ++i)
+		envelopes.emplace_back(boost::geometry::return_envelope<box_t>(rings[i]), i);
+
+	boost::geometry::index::rtree<value_t, boost::geometry::index::rstar<16>> index(envelopes);
+
+	// Without turns, a ring is inside another ring when any of its points is
+	std::vector<value_t> candidates;
+	for(std::size_t i = 0; i < boost::size(rings); ++i) {
+		candidates.clear();
+		index.query(boost::geometry::index::intersects(rings[i].front()), std::back_inserter(candidates));
+		for(auto const &candidate: candidates) {
+			if(candidate.second != i && boost::geometry::within(rings[i].front(), rings[candidate.second]))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+// Check if the polygon is valid, in which case the correction would return the polygon as is
+template<typename polygon_t>
+static inline bool is_valid_fast(polygon_t const &input, double remove_spike_min_area, boost::geometry::polygon_tag)
+{
+	if(!is_valid_ring(input.outer(), 1.0, remove_spike_min_area))
+		return false;
+
+	for(auto const &inner: input.inners()) {
+		if(!is_valid_ring(inner, -1.0, remove_spike_min_area))
+			return false;
+	}
+
+	if(has_self_turns(input))
+		return false;
+
+	// Without turns, an inner is inside the outer when any of its points is
+	for(auto const &inner: input.inners()) {
+		if(!boost::geometry::within(inner.front(), input.outer()))
+			return false;
+	}
+
+	return rings_disjoint(input.inners());
+}
+
+// Check if the multi polygon is valid, in which case the correction would return the multi polygon as is
+template<typename multi_polygon_t>
+static inline bool is_valid_fast(multi_polygon_t const &input, double remove_spike_min_area, boost::geometry::multi_polygon_tag)
+{
+	for(auto const &polygon: input) {
+		if(!is_valid_fast(polygon, remove_spike_min_area, boost::geometry::polygon_tag()))
+			return false;
+	}
+
+	if(boost::size(input) < 2)
+		return true;
+
+	if(has_self_turns(input))
+		return false;
+
+	// Without turns, polygons overlap when the outer of one polygon is inside another polygon
+	typedef typename boost::geometry::point_type<multi_polygon_t>::type point_t;
+	typedef boost::geometry::model::box<point_t> box_t;
+	typedef std::pair<box_t, std::size_t> value_t;
+
+	std::vector<value_t> envelopes;
+	envelopes.reserve(boost::size(input));
+	for(std::size_t i = 0; i < boost::size(input); ++i)
+		envelopes.emplace_back(boost::geometry::return_envelope<box_t>(input[i]), i);
+
+	boost::geometry::index::rtree<value_t, boost::geometry::index::rstar<16>> index(envelopes);
+
+	std::vector<value_t> candidates;
+	for(std::size_t i = 0; i < boost::size(input); ++i) {
+		auto const &p = input[i].outer().front();
+		candidates.clear();
+		index.query(boost::geometry::index::intersects(p), std::back_inserter(candidates));
+		for(auto const &candidate: candidates) {
+			if(candidate.second != i && boost::geometry::within(p, input[candidate.second]))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+template<typename geometry_t>
+static inline bool is_valid_fast(geometry_t const &input, double remove_spike_min_area)
+{
+	return is_valid_fast(input, remove_spike_min_area, typename boost::geometry::tag<geometry_t>::type());
+}
+
+// Copy the polygon to the output when it is valid, returns false when it has to be corrected
+template<typename polygon_t, typename multi_polygon_t>
+static inline bool copy_if_valid(polygon_t const &input, multi_polygon_t &output, double remove_spike_min_area, boost::geometry::polygon_tag)
+{
+	if(!is_valid_fast(input, remove_spike_min_area, boost::geometry::polygon_tag()))
+		return false;
+
+	output.push_back(input);
+	return true;
+}
+
+template<typename multi_polygon_t>
+static inline bool copy_if_valid(multi_polygon_t const &input, multi_polygon_t &output, double remove_spike_min_area, boost::geometry::multi_polygon_tag)
+{
+	if(!is_valid_fast(input, remove_spike_min_area, boost::geometry::multi_polygon_tag()))
+		return false;
+
+	output.insert(output.end(), input.begin(), input.end());
+	return true;
+}
+
+template<typename geometry_t, typename multi_polygon_t>
+static inline bool copy_if_valid(geometry_t const &input, multi_polygon_t &output, double remove_spike_min_area)
+{
+	return copy_if_valid(input, output, remove_spike_min_area, typename boost::geometry::tag<geometry_t>::type());
+}
+
+// Correct the outer ring of the polygon, the generated rings are filled into a single multi_polygon
+template<
+	typename fill_function_t,
+	typename ring_t,
+	typename multi_polygon_t
+	>
+static inline void correct_outer(std::vector<std::pair<ring_t, double>> &outer_rings, std::vector<std::pair<multi_polygon_t, double>> &combined_outers, fill_function_t const &fill)
+{
+	typedef typename boost::range_value<multi_polygon_t>::type polygon_t;
+
+	// Calculate all outers 
+	for(auto &i: outer_rings) {
+		polygon_t poly;
+		poly.outer() = std::move(i.first);
+
+		combined_outers.push_back(std::make_pair(multi_polygon_t(), i.second));
+		combined_outers.back().first.push_back(std::move(poly));
+	}
+
+	// fill the collected outers and combine into single multi_polygon
+	fill(combined_outers);
+}
+
+// Find the inners of the polygon, starting at inner first, which cross or touch any other ring 
+// of the polygon. Crossings and touches between the rings before inner first are not tested.
+template<typename polygon_t>
+static inline std::vector<bool> inners_with_turns(polygon_t const &polygon, std::size_t first)
+{
+	typedef typename boost::geometry::point_type<polygon_t>::type point_t;
+
+	// The outer is ring 0, inner i is ring i + 1
+	section_index<point_t> index;
+	index.add(polygon.outer(), 0);
+	for(std::size_t i = 0; i < first; ++i)
+		index.add(polygon.inners()[i], i + 1);
+
+	std::size_t first_section = index.sections.size();
+	for(std::size_t i = first; i < polygon.inners().size(); ++i)
+		index.add(polygon.inners()[i], i + 1);
+	index.build();
+
+	auto ring = [&polygon](std::size_t r) -> typename boost::geometry::ring_type<polygon_t>::type const & { 
+		return r == 0 ? polygon.outer() : polygon.inners()[r - 1]; 
+	};
+
+	std::vector<bool> result(polygon.inners().size(), false);
+	index.query_pairs([&](std::size_t a, std::size_t b) {
+		auto const &section_a = index.sections[a];
+		auto const &section_b = index.sections[b];
+		bool tested_a = section_a.ring > first;
+		if(section_a.ring == section_b.ring || (result[section_b.ring - 1] && (!tested_a || result[section_a.ring - 1])))
+			return;
+
+		auto const &ring_a = ring(section_a.ring);
+		auto const &ring_b = ring(section_b.ring);
+		bool turn = false;
+		for(std::size_t i = section_a.begin; !turn && i < section_a.end; ++i) {
+			for(std::size_t j = section_b.begin; !turn && j < section_b.end; ++j)
+				segment_intersection::apply(ring_a[i], ring_a[i + 1], ring_b[j], ring_b[j + 1], [&turn](point_t const &) { turn = true; });
+		}
+
+		if(turn) {
+			result[section_b.ring - 1] = true;
+			if(tested_a)
+				result[section_a.ring - 1] = true;
+		}
+	}, first_section);
+
+	return result;
+}
+
+// Check for every point if it is inside the simple ring, by counting the crossings of a horizontal 
+// ray. The points are sorted on y, so every edge is only tested against the points in its y range.
+template<typename ring_t, typename point_t>
+static inline std::vector<bool> ring_contains_points(ring_t const &ring, std::vector<point_t> const &points)
+{
+	std::vector<std::pair<double, std::size_t>> order;
+	order.reserve(points.size());
+	for(std::size_t i = 0; i < points.size(); ++i)
+		order.emplace_back(double(boost::geometry::get<1>(points[i])), i);
+	std::sort(order.begin(), order.end());
+
+	std::vector<bool> inside(points.size(), false);
+	for(std::size_t i = 0; i + 1 < boost::size(ring); ++i) {
+		double ax = double(boost::geometry::get<0>(ring[i])), ay = double(boost::geometry::get<1>(ring[i]));
+		double bx = double(boost::geometry::get<0>(ring[i + 1])), by = double(boost::geometry::get<1>(ring[i + 1]));
+		if(ay == by)
+			continue;
+
+		// Points with y in (min(ay, by), max(ay, by)] are crossed by the edge
+		auto first = std::upper_bound(order.begin(), order.end(), std::make_pair(std::min(ay, by), points.size()));
+		auto last = std::upper_bound(first, order.end(), std::make_pair(std::max(ay, by), points.size()));
+		for(auto it = first; it != last; ++it) {
+			if(double(boost::geometry::get<0>(points[it->second])) < ax + (it->first - ay) * (bx - ax) / (by - ay))
+				inside[it->second] = !inside[it->second];
+		}
+	}
+	return inside;
+}
+
+// Cut the inners out of the outers. The outer which can contain an inner is found by its envelope.
+// An inner inside a single outer, which does not cross or touch the rings of the outer, is added
+// to the outer as is. Only the remaining inners are cut out of the outers using the difference.
+template<
+	typename difference_function_t,
+	typename multi_polygon_t
+	>
+static inline void difference_inners(multi_polygon_t &outers, multi_polygon_t &inners, multi_polygon_t &output, difference_function_t const &difference)
+{
+	typedef typename boost::geometry::point_type<multi_polygon_t>::type point_t;
+	typedef boost::geometry::model::box<point_t> box_t;
+	typedef std::pair<box_t, std::size_t> value_t;
+
+	std::vector<value_t> envelopes;
+	envelopes.reserve(boost::size(outers));
+	for(std::size_t i = 0; i < boost::size(outers); ++i)
+		envelopes.emplace_back(boost::geometry::return_envelope<box_t>(outers[i]), i);
+
+	boost::geometry::index::rtree<value_t, boost::geometry::index::rstar<16>> index(envelopes);
+
+	// Assign every inner without inners of its own to the only outer of which the envelope intersects
+	std::vector<std::vector<std::size_t>> assigned(boost::size(outers));
+	std::vector<value_t> candidates;
+	for(std::size_t i = 0; i < boost::size(inners); ++i) {
+		if(!inners[i].inners().empty())
+			continue;
+
+		auto envelope = boost::geometry::return_envelope<box_t>(inners[i]);
+		candidates.clear();
+		index.query(boost::geometry::index::intersects(envelope), std::back_inserter(candidates));
+		if(candidates.size() == 1 && boost::geometry::covered_by(envelope, candidates.front().first))
+			assigned[candidates.front().second].push_back(i);
+	}
+
+	std::vector<bool> added(boost::size(inners), false);
+	for(std::size_t i = 0; i < boost::size(outers); ++i) {
+		if(assigned[i].empty())
+			continue;
+
+		auto &outer = outers[i];
+		std::size_t own_inners = outer.inners().size();
+		for(auto j: assigned[i]) {
+			outer.inners().push_back(inners[j].outer());
+			std::reverse(outer.inners().back().begin(), outer.inners().back().end());
+		}
+
+		// Without turns, an inner is inside the outer when any of its points is, and it is
+		// disjoint from the inners of the outer when none of their points are inside each other
+		auto turns = inners_with_turns(outer, own_inners);
+		std::vector<point_t> points;
+		for(std::size_t k = 0; k < assigned[i].size(); ++k)
+			points.push_back(outer.inners()[own_inners + k].front());
+
+		auto inside = ring_contains_points(outer.outer(), points);
+		for(std::size_t j = 0; j < own_inners; ++j) {
+			auto const &own = outer.inners()[j];
+			auto in_own = ring_contains_points(own, points);
+			for(std::size_t k = 0; k < assigned[i].size(); ++k) {
+				auto const &ring = outer.inners()[own_inners + k];
+				if(in_own[k] || (inside[k] && boost::geometry::covered_by(own.front(), boost::geometry::return_envelope<box_t>(ring)) && boost::geometry::within(own.front(), ring)))
+					inside[k] = false;
+			}
+		}
+
+		for(std::size_t k = 0; k < assigned[i].size(); ++k)
+			added[assigned[i][k]] = inside[k] && !turns[own_inners + k];
+
+		// Remove the inners which are cut out using the difference
+		std::size_t count = own_inners;
+		for(std::size_t k = 0; k < assigned[i].size(); ++k) {
+			if(!added[assigned[i][k]])
+				continue;
+			if(count != own_inners + k)
+				outer.inners()[count] = std::move(outer.inners()[own_inners + k]);
+			++count;
+		}
+		outer.inners().resize(count);
+	}
+
+	multi_polygon_t remaining;
+	for(std::size_t i = 0; i < boost::size(inners); ++i) {
+		if(!added[i])
+			remaining.push_back(std::move(inners[i]));
+	}
+
+	if(boost::empty(remaining)) {
+		for(auto &poly: outers)
+			output.push_back(std::move(poly));
+		return;
+	}
+
+	difference(outers, remaining, output);
+}
+
+// Correct the outer and inners of a polygon, the rings of the input are moved into the correction
+template<
+	typename fill_function_t,
+	typename combine_function_t,
+	typename difference_function_t,
+	typename point_t = boost::geometry::model::d2::point_xy<double>, 
+	typename polygon_t = boost::geometry::model::polygon<point_t>,
+	typename ring_t = boost::geometry::model::ring<point_t>,
+	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>,
+	typename statistics_t = no_statistics
+	>
+static inline void correct_rings(polygon_t &input, multi_polygon_t &output, double remove_spike_min_area, fill_function_t const &fill, combine_function_t const &combine, difference_function_t const &difference, correct_workspace<point_t, ring_t, statistics_t> &workspace)
+{
+	auto &statistics = workspace.statistics;
+	if(!input.inners().empty())
+		snap_polygon(input, workspace.snap);
+
+	auto order = boost::geometry::point_order<polygon_t>::value;
+	auto outer_rings = correct_inplace(input.outer(), order, remove_spike_min_area, workspace);
+
+	std::vector<std::pair<multi_polygon_t, double>> combined_outers;
+	{
+		stage_timer<statistics_t> timer(statistics, correct_stage::fill);
+		correct_outer(outer_rings, combined_outers, fill);
+	}
+
+	// Calculate all inners and combine them if possible
+	std::vector<multi_polygon_t> new_inners(input.inners().size());
+	for(std::size_t i = 0; i < input.inners().size(); ++i) {
+		polygon_t poly;
+		poly.outer() = std::move(input.inners()[i]);
+
+		correct_inplace(poly, new_inners[i], remove_spike_min_area, fill, combine, difference, workspace);
+	}
+
+	stage_timer<statistics_t> timer(statistics, correct_stage::combine);
+
+	multi_polygon_t combined_inners;
+	combine_reduce(new_inners, combined_inners, [&statistics, &combine](multi_polygon_t &a, multi_polygon_t &b) {
+		statistics.add_overlay_call();
+		combine(a, b);
+	});
+
+	// Cut out all inners from all the outers
+	if(!combined_outers.empty()) {
+		difference_inners(combined_outers.front().first, combined_inners, output, [&statistics, &difference](multi_polygon_t &a, multi_polygon_t &b, multi_polygon_t &result) {
+			statistics.add_overlay_call();
+			difference(a, b, result);
+		});
+	}
+}
+
+template<
+	typename fill_function_t,
+	typename combine_function_t,
+	typename difference_function_t,
+	typename point_t = boost::geometry::model::d2::point_xy<double>, 
+	typename polygon_t = boost::geometry::model::polygon<point_t>,
+	typename ring_t = boost::geometry::model::ring<point_t>,
+	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>,
+	typename statistics_t = no_statistics
+	>
+static inline void correct_inplace(polygon_t &input, multi_polygon_t &output, double remove_spike_min_area, fill_function_t const &fill, combine_function_t const &combine, difference_function_t const &difference, correct_workspace<point_t, ring_t, statistics_t> &workspace)
+{
+	correct_rings(input, output, remove_spike_min_area, fill, combine, difference, workspace);
+}
+
+template<
+	typename fill_function_t,
+	typename combine_function_t,
+	typename difference_function_t,
+	typename point_t = boost::geometry::model::d2::point_xy<double>, 
+	typename polygon_t = boost::geometry::model::polygon<point_t>,
+	typename ring_t = boost::geometry::model::ring<point_t>,
+	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>,
+	typename statistics_t = no_statistics
+	>
+static inline void correct(polygon_t const &input, multi_polygon_t &output, double remove_spike_min_area, fill_function_t const &fill, combine_function_t const &combine, difference_function_t const &difference, correct_workspace<point_t, ring_t, statistics_t> &workspace)
+{
+	polygon_t copy = input;
+	correct_rings(copy, output, remove_spike_min_area, fill, combine, difference, workspace);
+}
+
+template<
+	typename fill_function_t,
+	typename combine_function_t,
+	typename difference_function_t,
+	typename point_t = boost::geometry::model::d2::point_xy<double>, 
+	typename polygon_t = boost::geometry::model::polygon<point_t>,
+	typename ring_t = boost::geometry::model::ring<point_t>,
+	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>
+	>
+static inline void correct(polygon_t const &input, multi_polygon_t &output, double remove_spike_min_area, fill_function_t const &fill, combine_function_t const &combine, difference_function_t const &difference)
+{
+	correct_workspace_t<polygon_t> workspace;
+	correct(input, output, remove_spike_min_area, fill, combine, difference, workspace);
+}
+
+template<
+	typename fill_function_t,
+	typename combine_function_t,
+	typename difference_function_t,
+	typename point_t = boost::geometry::model::d2::point_xy<double>, 
+	typename polygon_t = boost::geometry::model::polygon<point_t>,
+	typename ring_t = boost::geometry::model::ring<point_t>,
+	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>
+	>
+static inline void correct_rings(polygon_t &input, multi_polygon_t &output, double remove_spike_min_area, fill_function_t const &fill, combine_function_t const &combine, difference_function_t const &difference, thread_pool &pool)
+{
+	if(!input.inners().empty()) {
+		snap_rounding<typename boost::geometry::point_type<polygon_t>::type> snap;
+		snap_polygon(input, snap);
+	}
+
+	std::vector<std::pair<multi_polygon_t, double>> combined_outers;
+	std::vector<multi_polygon_t> new_inners(input.inners().size());
+
+	// Correct the outer and all inners concurrently
+	pool.parallel_for(new_inners.size() + 1, [&](std::size_t i) {
+		correct_workspace_t<polygon_t> workspace;
+		if(i == 0) {
+			auto order = boost::geometry::point_order<polygon_t>::value;
+			auto outer_rings = correct_inplace(input.outer(), order, remove_spike_min_area, workspace);
+			correct_outer(outer_rings, combined_outers, fill);
+			return;
+		}
+
+		polygon_t poly;
+		poly.outer() = std::move(input.inners()[i - 1]);
+
+		correct_inplace(poly, new_inners[i - 1], remove_spike_min_area, fill, combine, difference, workspace);
+	});
+
+	multi_polygon_t combined_inners;
+	combine_reduce(new_inners, combined_inners, combine, pool);
+
+	// Cut out all inners from all the outers
+	if(!combined_outers.empty()) {
+		difference_inners(combined_outers.front().first, combined_inners, output, difference);
+	}
+}
+
+template<
+	typename fill_function_t,
+	typename combine_function_t,
+	typename difference_function_t,
+	typename point_t = boost::geometry::model::d2::point_xy<double>, 
+	typename polygon_t = boost::geometry::model::polygon<point_t>,
+	typename ring_t = boost::geometry::model::ring<point_t>,
+	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>
+	>
+static inline void correct(polygon_t const &input, multi_polygon_t &output, double remove_spike_min_area, fill_function_t const &fill, combine_function_t const &combine, difference_function_t const &difference, thread_pool &pool)
+{
+	polygon_t copy = input;
+	correct_rings(copy, output, remove_spike_min_area, fill, combine, difference, pool);
+}
+
+template<
+	typename fill_function_t,
+	typename combine_function_t,
+	typename difference_function_t,
+	typename point_t = boost::geometry::model::d2::point_xy<double>, 
+	typename polygon_t = boost::geometry::model::polygon<point_t>,
+	typename ring_t = boost::geometry::model::ring<point_t>,
+	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>,
+	typename statistics_t = no_statistics
+	>
+static inline void correct(multi_polygon_t const &input, multi_polygon_t &output, double remove_spike_min_area, fill_function_t const &fill, combine_function_t const &combine, difference_function_t const &difference, correct_workspace<point_t, ring_t, statistics_t> &workspace)
+{
+	std::vector<multi_polygon_t> new_polygons(input.size());
+	for(std::size_t i = 0; i < input.size(); ++i)
+		correct(input[i], new_polygons[i], remove_spike_min_area, fill, combine, difference, workspace);
+
+	auto &statistics = workspace.statistics;
+	stage_timer<statistics_t> timer(statistics, correct_stage::combine);
+	combine_reduce(new_polygons, output, [&statistics, &combine](multi_polygon_t &a, multi_polygon_t &b) {
+		statistics.add_overlay_call();
+		combine(a, b);
+	});
+}
+
+template<
+	typename fill_function_t,
+	typename combine_function_t,
+	typename difference_function_t,
+	typename point_t = boost::geometry::model::d2::point_xy<double>, 
+	typename polygon_t = boost::geometry::model::polygon<point_t>,
+	typename ring_t = boost::geometry::model::ring<point_t>,
+	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>
+	>
+static inline void correct(multi_polygon_t const &input, multi_polygon_t &output, double remove_spike_min_area, fill_function_t const &fill, combine_function_t const &combine, difference_function_t const &difference)
+{
+	correct_workspace_t<multi_polygon_t> workspace;
+	correct(input, output, remove_spike_min_area, fill, combine, difference, workspace);
+}
+
+// Correct the multi polygon in place, the polygons of the input are moved into the correction
+template<
+	typename fill_function_t,
+	typename combine_function_t,
+	typename difference_function_t,
+	typename point_t = boost::geometry::model::d2::point_xy<double>, 
+	typename polygon_t = boost::geometry::model::polygon<point_t>,
+	typename ring_t = boost::geometry::model::ring<point_t>,
+	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>,
+	typename statistics_t = no_statistics
+	>
+static inline void correct_inplace(multi_polygon_t &input, double remove_spike_min_area, fill_function_t const &fill, combine_function_t const &combine, difference_function_t const &difference, correct_workspace<point_t, ring_t, statistics_t> &workspace)
+{
+	std::vector<multi_polygon_t> new_polygons(input.size());
+	for(std::size_t i = 0; i < input.size(); ++i)
+		correct_inplace(input[i], new_polygons[i], remove_spike_min_area, fill, combine, difference, workspace);
+
+	input.clear();
+	auto &statistics = workspace.statistics;
+	stage_timer<statistics_t> timer(statistics, correct_stage::combine);
+	combine_reduce(new_polygons, input, [&statistics, &combine](multi_polygon_t &a, multi_polygon_t &b) {
+		statistics.add_overlay_call();
+		combine(a, b);
+	});
+}
+
+template<
+	typename fill_function_t,
+	typename combine_function_t,
+	typename difference_function_t,
+	typename point_t = boost::geometry::model::d2::point_xy<double>, 
+	typename polygon_t = boost::geometry::model::polygon<point_t>,
+	typename ring_t = boost::geometry::model::ring<point_t>,
+	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>
+	>
+static inline void correct_inplace(multi_polygon_t &input, double remove_spike_min_area, fill_function_t const &fill, combine_function_t const &combine, difference_function_t const &difference)
+{
+	correct_workspace_t<multi_polygon_t> workspace;
+	correct_inplace(input, remove_spike_min_area, fill, combine, difference, workspace);
+}
+
+template<
+	typename fill_function_t,
+	typename combine_function_t,
+	typename difference_function_t,
+	typename point_t = boost::geometry::model::d2::point_xy<double>, 
+	typename polygon_t = boost::geometry::model::polygon<point_t>,
+	typename ring_t = boost::geometry::model::ring<point_t>,
+	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>
+	>
+static inline void correct(multi_polygon_t const &input, multi_polygon_t &output, double remove_spike_min_area, fill_function_t const &fill, combine_function_t const &combine, difference_function_t const &difference, thread_pool &pool)
+{
+	// Polygons are corrected concurrently, combining is done in the same order as the serial correct
+	std::vector<multi_polygon_t> new_polygons(input.size());
+	pool.parallel_for(input.size(), [&](std::size_t i) {
+		correct(input[i], new_polygons[i], remove_spike_min_area, fill, combine, difference, pool);
+	});
+
+	combine_reduce(new_polygons, output, combine, pool);
+}
+
+// Polygon and multi polygon type for correcting a polygon or multi polygon
+template<typename geometry_t, typename tag_t = typename boost::geometry::tag<geometry_t>::type>
+struct correct_types
+{
+	typedef geometry_t polygon_t;
+	typedef boost::geometry::model::multi_polygon<polygon_t> multi_polygon_t;
+};
+
+template<typename geometry_t>
+struct correct_types<geometry_t, boost::geometry::multi_polygon_tag>
+{
+	typedef typename boost::range_value<geometry_t>::type polygon_t;
+	typedef geometry_t multi_polygon_t;
+};
+
+// Polygon passed as rvalue, of which the storage can be reused
+template<typename geometry_t>
+struct is_polygon_rvalue : std::integral_constant<bool, 
+	!std::is_lvalue_reference<geometry_t>::value && !std::is_const<geometry_t>::value &&
+	std::is_same<typename boost::geometry::tag<typename std::remove_reference<geometry_t>::type>::type, boost::geometry::polygon_tag>::value>
+{ };
+
+
+// Cut lines of a grid of tiles. The first and last lines are the bounds of the input, 
+// tile (i, j) covers [x[i], x[i + 1]] x [y[j], y[j + 1]].
+struct tile_grid
+{
+	std::vector<double> x;
+	std::vector<double> y;
+
+	std::size_t columns() const { return x.size() - 1; }
+	std::size_t rows() const { return y.size() - 1; }
+};
+
+// Cut lines at quantiles of the vertex coordinates, so every tile has about the same 
+// number of vertices
+static inline std::vector<double> tile_cut_lines(std::vector<double> &coordinates, std::size_t count)
+{
+	auto minmax = std::minmax_element(coordinates.begin(), coordinates.end());
+	double min = *minmax.first, max = *minmax.second;
+
+	std::vector<double> lines(1, min);
+	for(std::size_t i = 1; i < count; ++i) {
+		auto nth = coordinates.begin() + coordinates.size() * i / count;
+		std::nth_element(coordinates.begin(), nth, coordinates.end());
+		if(*nth > lines.back())
+			lines.push_back(*nth);
+	}
+	if(max > lines.back())
+		lines.push_back(max);
+	return lines;
+}
+
+template<typename polygon_t>
+static inline tile_grid tile_grid_create(polygon_t const &input, std::size_t tile_vertices)
+{
+	std::vector<double> x, y;
+	auto add_ring = [&x, &y](typename boost::geometry::ring_type<polygon_t>::type const &ring) {
+		for(auto const &p: ring) {
+			x.push_back(double(boost::geometry::get<0>(p)));
+			y.push_back(double(boost::geometry::get<1>(p)));
+		}
+	};
+	add_ring(input.outer());
+	for(auto const &inner: input.inners())
+		add_ring(inner);
+
+	tile_grid grid;
+	if(x.empty())
+		return grid;
+
+	std::size_t count = std::size_t(std::ceil(std::sqrt(double(x.size()) / double(std::max<std::size_t>(tile_vertices, 1)))));
+	count = std::max<std::size_t>(count, 1);
+	grid.x = tile_cut_lines(x, count);
+	grid.y = tile_cut_lines(y, count);
+	return grid;
+}
+
+// Split the segments of the ring at the cut lines, so every segment lies within a single 
+// tile. Split points are exactly on the cut line and are calculated from the segment in 
+// point order, so the same point is found for both tiles next to the cut line.
+template<typename ring_t>
+static inline void tile_split_ring(ring_t const &ring, tile_grid const &grid, ring_t &output)
+{
+	typedef typename boost::geometry::point_type<ring_t>::type point_t;
+	typedef typename boost::geometry::coordinate_type<point_t>::type coordinate_t;
+
+	auto coordinate = [](double v) {
+		return coordinate_t(std::is_integral<coordinate_t>::value ? double(std::llround(v)) : v);
+	};
+
+	compare_point_less<point_t> less;
+	std::vector<std::pair<double, point_t>> splits;
+
+	output.clear();
+	if(boost::empty(ring))
+		return;
+
+	for(auto i = boost::begin(ring), j = std::next(i); j != boost::end(ring); ++i, ++j) {
+		output.push_back(*i);
+
+		bool forward = less(*i, *j);
+		point_t const &lo = forward ? *i : *j;
+		point_t const &hi = forward ? *j : *i;
+		double lo_x = double(boost::geometry::get<0>(lo)), lo_y = double(boost::geometry::get<1>(lo));
+		double hi_x = double(boost::geometry::get<0>(hi)), hi_y = double(boost::geometry::get<1>(hi));
+
+		splits.clear();
+		auto add_splits = [&](std::vector<double> const &lines, double lo_v, double hi_v, bool vertical) {
+			double min_v = std::min(lo_v, hi_v), max_v = std::max(lo_v, hi_v);
+			for(auto k = std::upper_bound(lines.begin(), lines.end(), min_v); k != lines.end() && *k < max_v; ++k) {
+				double t = (*k - lo_v) / (hi_v - lo_v);
+				point_t p;
+				if(vertical) {
+					boost::geometry::set<0>(p, coordinate(*k));
+					boost::geometry::set<1>(p, coordinate(lo_y + t * (hi_y - lo_y)));
+				} else {
+					boost::geometry::set<0>(p, coordinate(lo_x + t * (hi_x - lo_x)));
+					boost::geometry::set<1>(p, coordinate(*k));
+				}
+				splits.push_back(std::make_pair(forward ? t : 1.0 - t, p));
+			}
+		};
+		add_splits(grid.x, lo_x, hi_x, true);
+		add_splits(grid.y, lo_y, hi_y, false);
+
+		std::sort(splits.begin(), splits.end(), 
+			[](std::pair<double, point_t> const &a, std::pair<double, point_t> const &b) { return a.first < b.first; });
+		for(auto const &split: splits)
+			output.push_back(split.second);
+	}
+	output.push_back(*std::prev(boost::end(ring)));
+}
+
+// Ring clipped to a tile. Every run of segments outside the tile, or on its boundary, is 
+// replaced by a path around the tile which passes the same corners. Every point of the paths
+// gets its own distance from the tile, so the paths do not overlap each other or the segments
+// inside the tile, also when a path winds around the tile more than once. The winding number 
+// of the clipped ring around every point inside the tile equals that of the ring, the part 
+// outside the tile is removed after correcting. The number of path points is kept between 
+// the rings of a polygon, so the paths of different rings do not overlap either.
+template<typename ring_t>
+static inline void tile_clip_ring(ring_t const &ring, double x0, double y0, double x1, double y1, std::size_t &path_points, ring_t &output)
+{
+	typedef typename boost::geometry::point_type<ring_t>::type point_t;
+	typedef typename boost::geometry::coordinate_type<point_t>::type coordinate_t;
+
+	output.clear();
+	std::size_t size = boost::size(ring);
+	if(size < 4)
+		return;
+
+	double const width = x1 - x0, height = y1 - y0, perimeter = 2 * (width + height);
+	double const corners[4] = { 0.0, width, width + height, 2 * width + height };
+
+	// Distance of the next point of a path, integer coordinates need distinct integers
+	double const margin = 0.01 * std::max(width, height);
+	auto distance = [&path_points, margin]() {
+		double n = double(path_points++);
+		if(std::is_integral<coordinate_t>::value)
+			return n + 1;
+		return margin * (n + 1) / (n + 2);
+	};
+
+	auto get_x = [](point_t const &p) { return double(boost::geometry::get<0>(p)); };
+	auto get_y = [](point_t const &p) { return double(boost::geometry::get<1>(p)); };
+	auto make_point = [](double x, double y) {
+		point_t p;
+		boost::geometry::set<0>(p, coordinate_t(x));
+		boost::geometry::set<1>(p, coordinate_t(y));
+		return p;
+	};
+	auto corner = [&](std::size_t i, double d) {
+		return make_point(i == 0 || i == 3 ? x0 - d : x1 + d, i < 2 ? y0 - d : y1 + d);
+	};
+
+	// Segment with its middle strictly inside the tile
+	auto interior = [&](point_t const &a, point_t const &b) {
+		double x = (get_x(a) + get_x(b)) / 2, y = (get_y(a) + get_y(b)) / 2;
+		return x > x0 && x < x1 && y > y0 && y < y1;
+	};
+
+	// Position along the boundary counter clockwise from (x0, y0), of the nearest point on the boundary
+	auto position = [&](point_t const &p) {
+		double x = std::min(std::max(get_x(p), x0), x1);
+		double y = std::min(std::max(get_y(p), y0), y1);
+		double bottom = y - y0, right = x1 - x, top = y1 - y, left = x - x0;
+		double nearest = std::min(std::min(bottom, right), std::min(top, left));
+		if(bottom == nearest) return x - x0;
+		if(right == nearest) return width + (y - y0);
+		if(top == nearest) return width + height + (x1 - x);
+		return 2 * width + height + (y1 - y);
+	};
+
+	// Point at distance d outside of the tile, perpendicular to the nearest side. Points on a
+	// corner are moved along one side only, the corners of the paths are on the diagonals.
+	auto offset = [&](point_t const &p, double d) {
+		double x = std::min(std::max(get_x(p), x0), x1);
+		double y = std::min(std::max(get_y(p), y0), y1);
+		double bottom = y - y0, right = x1 - x, top = y1 - y, left = x - x0;
+		double nearest = std::min(std::min(bottom, right), std::min(top, left));
+		if(bottom == nearest) return make_point(x, y0 - d);
+		if(right == nearest) return make_point(x1 + d, y);
+		if(top == nearest) return make_point(x, y1 + d);
+		return make_point(x0 - d, y);
+	};
+
+	// Distance along the boundary between two positions on the same side
+	auto step = [perimeter](double from, double to) {
+		double d = to - from;
+		if(d > perimeter / 2) d -= perimeter;
+		if(d < -perimeter / 2) d += perimeter;
+		return d;
+	};
+
+	// Path of a run from p to q over boundary distance d
+	auto add_path = [&](point_t const &p, point_t const &q, double start, double d) {
+		output.push_back(offset(p, distance()));
+		double base = std::floor(start / perimeter) * perimeter;
+		if(d > 0) {
+			for(std::size_t i = 0; ; ++i) {
+				double c = base + corners[i % 4] + perimeter * double(i / 4);
+				if(c >= start + d) break;
+				if(c > start) output.push_back(corner(i % 4, distance()));
+			}
+		} else if(d < 0) {
+			for(std::size_t i = 0; ; ++i) {
+				double c = base + perimeter + corners[3 - i % 4] - perimeter * double(i / 4);
+				if(c <= start + d) break;
+				if(c < start) output.push_back(corner(3 - i % 4, distance()));
+			}
+		}
+		output.push_back(offset(q, distance()));
+		output.push_back(q);
+	};
+
+	// Start at a segment inside the tile, the ring is closed so the last point is skipped
+	std::size_t const count = size - 1;
+	auto const *points = &*boost::begin(ring);
+	std::size_t first = 0;
+	while(first < count && !interior(points[first], points[first + 1]))
+		++first;
+
+	if(first == count) {
+		// Ring outside of the tile, the tile is covered when the ring winds around it
+		double d = 0.0, last = position(points[0]);
+		for(std::size_t i = 1; i <= count; ++i) {
+			double next = position(points[i % count]);
+			d += step(last, next);
+			last = next;
+		}
+
+		if(std::abs(d) > perimeter / 2) {
+			double distance_box = distance();
+			for(std::size_t i = 0; i <= 4; ++i)
+				output.push_back(corner(d > 0 ? i % 4 : (4 - i) % 4, distance_box));
+		}
+		return;
+	}
+
+	bool outside = false;
+	double start = 0.0, last = 0.0, d = 0.0;
+	output.push_back(points[first]);
+	for(std::size_t i = 0; i < count; ++i) {
+		point_t const &a = points[(first + i) % count];
+		point_t const &b = points[(first + i + 1) % count];
+		if(interior(a, b)) {
+			if(outside) {
+				add_path(output.back(), a, start, d);
+				outside = false;
+			}
+			output.push_back(b);
+		} else {
+			if(!outside) {
+				outside = true;
+				start = last = position(a);
+				d = 0.0;
+			}
+			double next = position(b);
+			d += step(last, next);
+			last = next;
+		}
+	}
+
+	if(outside)
+		add_path(output.back(), points[first], start, d);
+}
+
+// Clip a corrected ring to the tile, one side at a time. Parts of the ring outside the tile are
+// replaced by segments on the tile boundary, which may run back and forth. These cancel out 
+// when the tiles are stitched.
+template<typename ring_t>
+static inline void tile_clip_result(ring_t &ring, double x0, double y0, double x1, double y1)
+{
+	typedef typename boost::geometry::point_type<ring_t>::type point_t;
+	typedef typename boost::geometry::coordinate_type<point_t>::type coordinate_t;
+
+	auto coordinate = [](double v) {
+		return coordinate_t(std::is_integral<coordinate_t>::value ? double(std::llround(v)) : v);
+	};
+
+	// Keep the part with coordinate dimension on the side of line given by sign
+	ring_t clipped;
+	auto clip = [&](std::size_t dimension, double line, double sign) {
+		auto get = [dimension](point_t const &p) {
+			return double(dimension == 0 ? boost::geometry::get<0>(p) : boost::geometry::get<1>(p));
+		};
+		auto inside = [&](point_t const &p) { return sign * (get(p) - line) >= 0; };
+
+		clipped.clear();
+		std::size_t count = boost::size(ring);
+		for(std::size_t i = 0; i + 1 < count; ++i) {
+			point_t const &a = ring[i], &b = ring[i + 1];
+			if(inside(a))
+				clipped.push_back(a);
+			if(inside(a) != inside(b)) {
+				double t = (line - get(a)) / (get(b) - get(a));
+				double ax = double(boost::geometry::get<0>(a)), ay = double(boost::geometry::get<1>(a));
+				double bx = double(boost::geometry::get<0>(b)), by = double(boost::geometry::get<1>(b));
+				point_t p;
+				boost::geometry::set<0>(p, coordinate(dimension == 0 ? line : ax + t * (bx - ax)));
+				boost::geometry::set<1>(p, coordinate(dimension == 1 ? line : ay + t * (by - ay)));
+				clipped.push_back(p);
+			}
+		}
+		if(!clipped.empty())
+			clipped.push_back(clipped.front());
+		std::swap(ring, clipped);
+	};
+
+	clip(0, x0, 1.0);
+	clip(0, x1, -1.0);
+	clip(1, y0, 1.0);
+	clip(1, y1, -1.0);
+}
+
+// Correct the part of the polygon in tile (column, row), the rings are already split at the cut lines
+template<
+	typename polygon_t,
+	typename multi_polygon_t,
+	typename workspace_t
+	>
+static inline void correct_tile(polygon_t const &split, tile_grid const &grid, std::size_t column, std::size_t row, multi_polygon_t &output, double remove_spike_min_area, workspace_t &workspace)
 {
-	inline void operator()(std::vector<std::pair<multi_polygon_t, double>> &input) const
-	{
-		auto compare = [](std::pair<multi_polygon_t, double> const &a, std::pair<multi_polygon_t, double> const &b) { return std::abs(a.second) < std::abs(b.second); };
-		std::sort(input.begin(), input.end(), compare);
+	typedef typename boost::geometry::point_type<polygon_t>::type point_t;
 
-		fill_normalize_polygons(input);
+	double x0 = grid.x[column], x1 = grid.x[column + 1];
+	double y0 = grid.y[row], y1 = grid.y[row + 1];
 
-		while(input.size() > 1) {
-			std::size_t divide_i = input.size() / 2 + input.size() % 2;
-			for(std::size_t i = 0; i < input.size() / 2; ++i) {
-				std::size_t index = i + divide_i;
-				if(index < input.size()) {
-					multi_polygon_t result;
-					boost::geometry::sym_difference(input[index].first, input[i].first, result);
-					input[i].first = std::move(result);
-				}
+	polygon_t tile;
+	std::size_t path_points = 0;
+	tile_clip_ring(split.outer(), x0, y0, x1, y1, path_points, tile.outer());
+	if(boost::size(tile.outer()) < 4)
+		return;
+
+	for(auto const &inner: split.inners()) {
+		tile.inners().emplace_back();
+		tile_clip_ring(inner, x0, y0, x1, y1, path_points, tile.inners().back());
+		if(boost::size(tile.inners().back()) < 4)
+			tile.inners().pop_back();
+	}
+
+	correct(tile, output, remove_spike_min_area, 
+		fill_non_zero_winding_direct<point_t, polygon_t, multi_polygon_t>(), 
+		result_combine_multiple<multi_polygon_t, multi_polygon_t>, 
+		boost::geometry::difference<multi_polygon_t, multi_polygon_t, multi_polygon_t>,
+		workspace
+		);
+
+	// Remove the paths around the tile
+	for(auto &polygon: output) {
+		tile_clip_result(polygon.outer(), x0, y0, x1, y1);
+		for(auto &inner: polygon.inners())
+			tile_clip_result(inner, x0, y0, x1, y1);
+	}
+}
+
+// Stitch the tiles along the cut lines. Segments on a cut line are split at the points of 
+// the tiles on both sides of the line, so shared segments cancel out.
+template<
+	typename point_t,
+	typename polygon_t,
+	typename multi_polygon_t
+	>
+static inline void tile_stitch(std::vector<multi_polygon_t> const &tiles, tile_grid const &grid, multi_polygon_t &output)
+{
+	typedef typename boost::geometry::coordinate_type<point_t>::type coordinate_t;
+
+	std::vector<fill_edge<point_t>> edges;
+	for(auto const &tile: tiles) {
+		for(auto const &polygon: tile) {
+			fill_add_edges<point_t>(polygon.outer(), 1, edges);
+			for(auto const &inner: polygon.inners())
+				fill_add_edges<point_t>(inner, 1, edges);
+		}
+	}
+
+	auto on_line = [](std::vector<double> const &lines, double v) {
+		return std::binary_search(lines.begin(), lines.end(), v);
+	};
+
+	// Points on the vertical and horizontal cut lines, as (line, position on the line)
+	std::vector<std::pair<double, double>> vertical, horizontal;
+	for(auto const &edge: edges) {
+		for(point_t const *p: { &edge.from, &edge.to }) {
+			double x = double(boost::geometry::get<0>(*p)), y = double(boost::geometry::get<1>(*p));
+			if(on_line(grid.x, x))
+				vertical.emplace_back(x, y);
+			if(on_line(grid.y, y))
+				horizontal.emplace_back(y, x);
+		}
+	}
+	for(auto *points: { &vertical, &horizontal }) {
+		std::sort(points->begin(), points->end());
+		points->erase(std::unique(points->begin(), points->end()), points->end());
+	}
+
+	std::size_t count = edges.size();
+	for(std::size_t i = 0; i < count; ++i) {
+		fill_edge<point_t> edge = edges[i];
+		double from_x = double(boost::geometry::get<0>(edge.from)), from_y = double(boost::geometry::get<1>(edge.from));
+		double to_x = double(boost::geometry::get<0>(edge.to)), to_y = double(boost::geometry::get<1>(edge.to));
+
+		bool is_vertical = from_x == to_x && on_line(grid.x, from_x);
+		bool is_horizontal = !is_vertical && from_y == to_y && on_line(grid.y, from_y);
+		if(!is_vertical && !is_horizontal)
+			continue;
+
+		// Edges are stored from the lowest to the highest point, so the points in between are in order
+		auto const &points = is_vertical ? vertical : horizontal;
+		auto from = is_vertical ? std::make_pair(from_x, from_y) : std::make_pair(from_y, from_x);
+		auto to = is_vertical ? std::make_pair(to_x, to_y) : std::make_pair(to_y, to_x);
+		auto first = std::upper_bound(points.begin(), points.end(), from);
+		auto last = std::lower_bound(first, points.end(), to);
+		if(first == last)
+			continue;
+
+		point_t previous = edge.from;
+		for(auto k = first; k != last; ++k) {
+			point_t p;
+			boost::geometry::set<0>(p, coordinate_t(is_vertical ? k->first : k->second));
+			boost::geometry::set<1>(p, coordinate_t(is_vertical ? k->second : k->first));
+			if(k == first)
+				edges[i].to = p;
+			else
+				edges.push_back({ previous, p, edge.weight });
+			previous = p;
+		}
+		edges.push_back({ previous, edge.to, edge.weight });
+	}
+
+	fill_assemble_edges<point_t, polygon_t, multi_polygon_t>(edges, output);
+}
+
+// Remove the points added on the cut lines from the stitched tiles, where these are on a 
+// straight segment. Points of the input are kept.
+template<typename multi_polygon_t, typename point_t>
+static inline void tile_remove_split_points(multi_polygon_t &output, tile_grid const &grid, std::vector<point_t> const &input_points)
+{
+	compare_point_less<point_t> less;
+
+	auto is_split_point = [&](point_t const &p) {
+		return (std::binary_search(grid.x.begin(), grid.x.end(), double(boost::geometry::get<0>(p))) 
+			|| std::binary_search(grid.y.begin(), grid.y.end(), double(boost::geometry::get<1>(p))))
+			&& !std::binary_search(input_points.begin(), input_points.end(), p, less);
+	};
+
+	auto remove = [&](typename boost::geometry::ring_type<multi_polygon_t>::type &ring) {
+		std::size_t count = boost::size(ring);
+		if(count < 5)
+			return;
+
+		std::vector<point_t> kept;
+		kept.reserve(count);
+		for(std::size_t i = 0; i + 1 < count; ++i) {
+			point_t const &p = ring[i];
+			point_t const &a = kept.empty() ? ring[count - 2] : kept.back();
+			point_t const &b = ring[i + 1];
+			if(is_split_point(p)) {
+				double ax = double(boost::geometry::get<0>(a)) - double(boost::geometry::get<0>(p));
+				double ay = double(boost::geometry::get<1>(a)) - double(boost::geometry::get<1>(p));
+				double bx = double(boost::geometry::get<0>(b)) - double(boost::geometry::get<0>(p));
+				double by = double(boost::geometry::get<1>(b)) - double(boost::geometry::get<1>(p));
+				if(std::abs(ax * by - ay * bx) <= 1E-12 * std::sqrt((ax * ax + ay * ay) * (bx * bx + by * by)) && ax * bx + ay * by < 0)
+					continue;
 			}
+			kept.push_back(p);
+		}
+
+		if(kept.size() < 3)
+			return;
+		kept.push_back(kept.front());
+		ring.assign(kept.begin(), kept.end());
+	};
 
-			input.resize(divide_i);
-		} 
+	for(auto &polygon: output) {
+		remove(polygon.outer());
+		for(auto &inner: polygon.inners())
+			remove(inner);
 	}
-};
- 
+}
+
+// Split the rings of the polygon at the cut lines
+template<typename polygon_t>
+static inline polygon_t tile_split_polygon(polygon_t const &input, tile_grid const &grid)
+{
+	polygon_t split;
+	tile_split_ring(input.outer(), grid, split.outer());
+	split.inners().resize(input.inners().size());
+	for(std::size_t i = 0; i < input.inners().size(); ++i)
+		tile_split_ring(input.inners()[i], grid, split.inners()[i]);
+	return split;
+}
+
+// Points of the polygon, sorted
+template<typename polygon_t, typename point_t = typename boost::geometry::point_type<polygon_t>::type>
+static inline std::vector<point_t> tile_input_points(polygon_t const &input)
+{
+	std::vector<point_t> points(boost::begin(input.outer()), boost::end(input.outer()));
+	for(auto const &inner: input.inners())
+		points.insert(points.end(), boost::begin(inner), boost::end(inner));
+	std::sort(points.begin(), points.end(), compare_point_less<point_t>());
+	return points;
+}
+
+template<
+	typename polygon_t,
+	typename multi_polygon_t,
+	typename point_t = typename boost::geometry::point_type<polygon_t>::type
+	>
+static inline void correct_tiled(polygon_t const &input, multi_polygon_t &output, double remove_spike_min_area, std::size_t tile_vertices)
+{
+	tile_grid grid = tile_grid_create(input, tile_vertices);
+	if(grid.x.size() < 2 || grid.y.size() < 2)
+		return;
+
+	polygon_t split = tile_split_polygon(input, grid);
+
+	std::vector<multi_polygon_t> tiles(grid.columns() * grid.rows());
+	correct_workspace_t<polygon_t> workspace;
+	for(std::size_t i = 0; i < tiles.size(); ++i)
+		correct_tile(split, grid, i % grid.columns(), i / grid.columns(), tiles[i], remove_spike_min_area, workspace);
+
+	multi_polygon_t combined;
+	tile_stitch<point_t, polygon_t>(tiles, grid, combined);
+	tile_remove_split_points(combined, grid, tile_input_points(input));
+	output.insert(output.end(), combined.begin(), combined.end());
+}
+
+template<
+	typename polygon_t,
+	typename multi_polygon_t,
+	typename point_t = typename boost::geometry::point_type<polygon_t>::type
+	>
+static inline void correct_tiled(polygon_t const &input, multi_polygon_t &output, double remove_spike_min_area, std::size_t tile_vertices, thread_pool &pool)
+{
+	tile_grid grid = tile_grid_create(input, tile_vertices);
+	if(grid.x.size() < 2 || grid.y.size() < 2)
+		return;
+
+	polygon_t split = tile_split_polygon(input, grid);
+
+	// Tiles are corrected concurrently and stitched in the same order as the serial version
+	std::vector<multi_polygon_t> tiles(grid.columns() * grid.rows());
+	pool.parallel_for(tiles.size(), [&](std::size_t i) {
+		correct_workspace_t<polygon_t> workspace;
+		correct_tile(split, grid, i % grid.columns(), i / grid.columns(), tiles[i], remove_spike_min_area, workspace);
+	});
+
+	multi_polygon_t combined;
+	tile_stitch<point_t, polygon_t>(tiles, grid, combined);
+	tile_remove_split_points(combined, grid, tile_input_points(input));
+	output.insert(output.end(), combined.begin(), combined.end());
+}
+}
+
+// Corrects geometries one after another, using the non-zero winding rule. The 
+// buffers used for the correction are kept between calls, and can be allocated 
+// from a memory resource such as a std::pmr::monotonic_buffer_resource. With 
+// correct_statistics as statistics type, the statistics of all corrections are
+// recorded.
 template<
-	typename fill_function_t,
-	typename combine_function_t,
-	typename difference_function_t,
 	typename point_t = boost::geometry::model::d2::point_xy<double>, 
 	typename polygon_t = boost::geometry::model::polygon<point_t>,
-	typename ring_t = boost::geometry::model::ring<point_t>,
-	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>
+	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>,
+	typename statistics_t = impl::no_statistics
 	>
-static inline void correct(polygon_t const &input, multi_polygon_t &output, double remove_spike_min_area, fill_function_t const &fill, combine_function_t const &combine, difference_function_t const &difference)
+class corrector
 {
-	auto order = boost::geometry::point_order<polygon_t>::value;
-	auto outer_rings = correct(input.outer(), order, remove_spike_min_area);
+	typedef typename boost::geometry::ring_type<polygon_t>::type ring_t;
 
-	// Calculate all outers 
-	std::vector<std::pair<multi_polygon_t, double>> combined_outers;
+	double remove_spike_min_area;
+	fill_method fill = fill_method::direct;
+	bool check_valid = false;
+	impl::correct_workspace<point_t, ring_t, statistics_t> workspace;
 
-	for(auto &i: outer_rings) {
-		polygon_t poly;
-		poly.outer() = std::move(i.first);
+	// Call function with the fill function of the fill method
+	template<typename function_t>
+	void with_fill(function_t const &function)
+	{
+		if(fill == fill_method::overlay)
+			function(impl::fill_non_zero_winding<point_t, polygon_t, multi_polygon_t>());
+		else
+			function(impl::fill_non_zero_winding_direct<point_t, polygon_t, multi_polygon_t>());
+	}
 
-		combined_outers.push_back(std::make_pair(multi_polygon_t(), i.second));
-		combined_outers.back().first.push_back(std::move(poly));
+public:
+	explicit corrector(double remove_spike_min_area = 0.0, std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+		: remove_spike_min_area(remove_spike_min_area), workspace(resource)
+	{ }
+
+	// Remove repeated points from the rings before correcting, enabled by default
+	void set_remove_duplicates(bool remove_duplicates)
+	{
+		workspace.remove_duplicates = remove_duplicates;
 	}
 
-	// fill the collected outers and combine into single multi_polygon
-	fill(combined_outers);
+	// Remove points in the middle of straight segments from the rings before correcting
+	void set_remove_collinear(bool remove_collinear)
+	{
+		workspace.remove_collinear = remove_collinear;
+	}
 
-	// Calculate all inners and combine them if possible
-	multi_polygon_t combined_inners;
-	for(auto const &ring: input.inners()) {
-		polygon_t poly;
-		poly.outer() = std::move(ring);
+	// Method used to find the self intersections of the rings
+	void set_intersection_method(intersection_method method)
+	{
+		workspace.method = method;
+	}
 
-		multi_polygon_t new_inners;
-		correct(poly, new_inners, remove_spike_min_area, fill, combine, difference);
-		combine(combined_inners, new_inners);
+	// Method used to fill the traced rings
+	void set_fill_method(fill_method method)
+	{
+		fill = method;
 	}
 
-	// Cut out all inners from all the outers
-	if(!combined_outers.empty()) {
-		difference(combined_outers.front().first, combined_inners, output);
+	// Check the input for validity before correcting, disabled by default. Valid input is 
+	// copied to the output as is, and the correct functions return true.
+	void set_check_valid(bool check)
+	{
+		check_valid = check;
+	}
+
+	// Statistics of the corrections since construction
+	statistics_t const &statistics() const
+	{
+		return workspace.statistics;
+	}
+
+	// Correct the polygon, returns true when the input was valid and copied to the output as is
+	bool correct(polygon_t const &input, multi_polygon_t &output)
+	{
+		if(check_valid && impl::copy_if_valid(input, output, remove_spike_min_area))
+			return true;
+
+		with_fill([this, &input, &output](auto const &fill_function) {
+			impl::correct(input, output, remove_spike_min_area, fill_function, 
+				impl::result_combine_multiple<multi_polygon_t, multi_polygon_t>, 
+				boost::geometry::difference<multi_polygon_t, multi_polygon_t, multi_polygon_t>,
+				workspace
+				);
+		});
+		return false;
+	}
+
+	bool correct(multi_polygon_t const &input, multi_polygon_t &output)
+	{
+		if(check_valid && impl::copy_if_valid(input, output, remove_spike_min_area))
+			return true;
+
+		with_fill([this, &input, &output](auto const &fill_function) {
+			impl::correct(input, output, remove_spike_min_area, fill_function, 
+				impl::result_combine_multiple<multi_polygon_t, multi_polygon_t>, 
+				boost::geometry::difference<multi_polygon_t, multi_polygon_t, multi_polygon_t>,
+				workspace
+				);
+		});
+		return false;
+	}
+
+	bool correct_inplace(polygon_t &input, multi_polygon_t &output)
+	{
+		if(check_valid && impl::is_valid_fast(input, remove_spike_min_area)) {
+			output.push_back(std::move(input));
+			return true;
+		}
+
+		with_fill([this, &input, &output](auto const &fill_function) {
+			impl::correct_inplace(input, output, remove_spike_min_area, fill_function, 
+				impl::result_combine_multiple<multi_polygon_t, multi_polygon_t>, 
+				boost::geometry::difference<multi_polygon_t, multi_polygon_t, multi_polygon_t>,
+				workspace
+				);
+		});
+		return false;
+	}
+
+	bool correct_inplace(multi_polygon_t &geometry)
+	{
+		if(check_valid && impl::is_valid_fast(geometry, remove_spike_min_area))
+			return true;
+
+		with_fill([this, &geometry](auto const &fill_function) {
+			impl::correct_inplace(geometry, remove_spike_min_area, fill_function, 
+				impl::result_combine_multiple<multi_polygon_t, multi_polygon_t>, 
+				boost::geometry::difference<multi_polygon_t, multi_polygon_t, multi_polygon_t>,
+				workspace
+				);
+		});
+		return false;
+	}
+
+	// Correct all geometries of the input range, for every geometry a multi_polygon_t is written to the output
+	template<typename range_t, typename output_iterator_t>
+	output_iterator_t correct_batch(range_t const &input, output_iterator_t output)
+	{
+		for(auto const &geometry: input) {
+			multi_polygon_t result;
+			correct(geometry, result);
+			*output++ = std::move(result);
+		}
+
+		return output;
 	}
+};
+
+template<
+	typename range_t,
+	typename output_iterator_t,
+	typename polygon_t = typename impl::correct_types<typename boost::range_value<range_t>::type>::polygon_t,
+	typename multi_polygon_t = typename impl::correct_types<typename boost::range_value<range_t>::type>::multi_polygon_t,
+	typename point_t = typename boost::geometry::point_type<polygon_t>::type
+	>
+static inline output_iterator_t correct_batch(range_t const &input, output_iterator_t output, double remove_spike_min_area = 0.0)
+{
+	corrector<point_t, polygon_t, multi_polygon_t> batch(remove_spike_min_area);
+	return batch.correct_batch(input, output);
+}
+
+template<
+	typename point_t = boost::geometry::model::d2::point_xy<double>, 
+	typename polygon_t = boost::geometry::model::polygon<point_t>,
+	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>,
+	typename geometry_point_t = typename boost::geometry::point_type<polygon_t>::type
+	>
+static inline void correct(polygon_t const &input, multi_polygon_t &output, double remove_spike_min_area = 0.0)
+{
+	impl::correct(input, output, remove_spike_min_area, 
+		impl::fill_non_zero_winding_direct<geometry_point_t, polygon_t, multi_polygon_t>(), 
+		impl::result_combine_multiple<multi_polygon_t, multi_polygon_t>, 
+		boost::geometry::difference<multi_polygon_t, multi_polygon_t, multi_polygon_t>
+		);
+}
+
+template<
+	typename point_t = boost::geometry::model::d2::point_xy<double>, 
+	typename polygon_t = boost::geometry::model::polygon<point_t>,
+	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>,
+	typename geometry_point_t = typename boost::geometry::point_type<polygon_t>::type
+	>
+static inline void correct_odd_even(polygon_t const &input, multi_polygon_t &output, double remove_spike_min_area = 0.0)
+{
+	impl::correct(input, output, remove_spike_min_area, 
+		impl::fill_odd_even<geometry_point_t, polygon_t, multi_polygon_t>(), 
+		[](multi_polygon_t &a, multi_polygon_t const &b) {
+			multi_polygon_t result;
+			boost::geometry::sym_difference(a, b, result);
+			a = std::move(result); 
+		},
+		boost::geometry::sym_difference<multi_polygon_t, multi_polygon_t, multi_polygon_t>
+		);
+
+}
+
+// Correct a polygon that is no longer needed, the storage of the input is reused for the output
+template<
+	typename point_t = boost::geometry::model::d2::point_xy<double>, 
+	typename polygon_t = boost::geometry::model::polygon<point_t>,
+	typename multi_polygon_t = boost::geometry::model::multi_polygon<typename std::remove_reference<polygon_t>::type>,
+	typename geometry_point_t = typename boost::geometry::point_type<typename std::remove_reference<polygon_t>::type>::type,
+	typename std::enable_if<impl::is_polygon_rvalue<polygon_t>::value, int>::type = 0
+	>
+static inline void correct(polygon_t &&input, multi_polygon_t &output, double remove_spike_min_area = 0.0)
+{
+	corrector<geometry_point_t, polygon_t, multi_polygon_t>(remove_spike_min_area).correct_inplace(input, output);
+}
+
+template<
+	typename point_t = boost::geometry::model::d2::point_xy<double>, 
+	typename polygon_t = boost::geometry::model::polygon<point_t>,
+	typename multi_polygon_t = boost::geometry::model::multi_polygon<typename std::remove_reference<polygon_t>::type>,
+	typename geometry_point_t = typename boost::geometry::point_type<typename std::remove_reference<polygon_t>::type>::type,
+	typename std::enable_if<impl::is_polygon_rvalue<polygon_t>::value, int>::type = 0
+	>
+static inline void correct_odd_even(polygon_t &&input, multi_polygon_t &output, double remove_spike_min_area = 0.0)
+{
+	impl::correct_workspace_t<polygon_t> workspace;
+	impl::correct_inplace(input, output, remove_spike_min_area, 
+		impl::fill_odd_even<geometry_point_t, polygon_t, multi_polygon_t>(), 
+		[](multi_polygon_t &a, multi_polygon_t const &b) {
+			multi_polygon_t result;
+			boost::geometry::sym_difference(a, b, result);
+			a = std::move(result); 
+		},
+		boost::geometry::sym_difference<multi_polygon_t, multi_polygon_t, multi_polygon_t>,
+		workspace
+		);
+}
+
+
+template<
+	typename point_t = boost::geometry::model::d2::point_xy<double>, 
+	typename polygon_t = boost::geometry::model::polygon<point_t>,
+	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>,
+	typename geometry_point_t = typename boost::geometry::point_type<polygon_t>::type
+	>
+static inline void correct(polygon_t const &input, multi_polygon_t &output, double remove_spike_min_area, thread_pool &pool)
+{
+	impl::correct(input, output, remove_spike_min_area, 
+		impl::fill_non_zero_winding_direct<geometry_point_t, polygon_t, multi_polygon_t>(), 
+		impl::result_combine_multiple<multi_polygon_t, multi_polygon_t>, 
+		boost::geometry::difference<multi_polygon_t, multi_polygon_t, multi_polygon_t>,
+		pool
+		);
+}
+
+template<
+	typename point_t = boost::geometry::model::d2::point_xy<double>, 
+	typename polygon_t = boost::geometry::model::polygon<point_t>,
+	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>,
+	typename geometry_point_t = typename boost::geometry::point_type<polygon_t>::type
+	>
+static inline void correct_odd_even(polygon_t const &input, multi_polygon_t &output, double remove_spike_min_area, thread_pool &pool)
+{
+	impl::correct(input, output, remove_spike_min_area, 
+		impl::fill_odd_even<geometry_point_t, polygon_t, multi_polygon_t>(), 
+		[](multi_polygon_t &a, multi_polygon_t const &b) {
+			multi_polygon_t result;
+			boost::geometry::sym_difference(a, b, result);
+			a = std::move(result); 
+		},
+		boost::geometry::sym_difference<multi_polygon_t, multi_polygon_t, multi_polygon_t>,
+		pool
+		);
+}
+
+// Correct a large polygon in tiles of about tile_vertices vertices, using the non-zero winding 
+// rule. The rings are clipped to every tile, keeping their winding number inside the tile, so the
+// combined tiles equal the correction of the whole polygon.
+template<
+	typename point_t = boost::geometry::model::d2::point_xy<double>, 
+	typename polygon_t = boost::geometry::model::polygon<point_t>,
+	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>,
+	typename geometry_point_t = typename boost::geometry::point_type<polygon_t>::type
+	>
+static inline void correct_tiled(polygon_t const &input, multi_polygon_t &output, double remove_spike_min_area, std::size_t tile_vertices)
+{
+	impl::correct_tiled(input, output, remove_spike_min_area, tile_vertices);
+}
+
+template<
+	typename point_t = boost::geometry::model::d2::point_xy<double>, 
+	typename polygon_t = boost::geometry::model::polygon<point_t>,
+	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>,
+	typename geometry_point_t = typename boost::geometry::point_type<polygon_t>::type
+	>
+static inline void correct_tiled(polygon_t const &input, multi_polygon_t &output, double remove_spike_min_area, std::size_t tile_vertices, thread_pool &pool)
+{
+	impl::correct_tiled(input, output, remove_spike_min_area, tile_vertices, pool);
+}
+
+template<
+	typename point_t = boost::geometry::model::d2::point_xy<double>, 
+	typename polygon_t = boost::geometry::model::polygon<point_t>,
+	typename ring_t = boost::geometry::model::ring<point_t>,
+	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>,
+	typename geometry_polygon_t = typename boost::range_value<multi_polygon_t>::type,
+	typename geometry_point_t = typename boost::geometry::point_type<multi_polygon_t>::type
+	>
+static inline void correct(multi_polygon_t const &input, multi_polygon_t &output, double remove_spike_min_area = 0.0)
+{
+	corrector<geometry_point_t, geometry_polygon_t, multi_polygon_t>(remove_spike_min_area).correct(input, output);
+}
+
+template<
+	typename point_t = boost::geometry::model::d2::point_xy<double>, 
+	typename polygon_t = boost::geometry::model::polygon<point_t>,
+	typename ring_t = boost::geometry::model::ring<point_t>,
+	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>,
+	typename geometry_polygon_t = typename boost::range_value<multi_polygon_t>::type,
+	typename geometry_point_t = typename boost::geometry::point_type<multi_polygon_t>::type
+	>
+static inline void correct_odd_even(multi_polygon_t const &input, multi_polygon_t &output, double remove_spike_min_area = 0.0)
+{
+	impl::correct(input, output, remove_spike_min_area, 
+		impl::fill_odd_even<geometry_point_t, geometry_polygon_t, multi_polygon_t>(),
+		[](multi_polygon_t &a, multi_polygon_t const &b) {
+			multi_polygon_t result;
+			boost::geometry::sym_difference(a, b, result);
+			a = std::move(result); 
+		},
+		boost::geometry::sym_difference<multi_polygon_t, multi_polygon_t, multi_polygon_t>
+		);
+}
+
+// Correct and add the statistics of the correction to the given statistics
+template<
+	typename point_t = boost::geometry::model::d2::point_xy<double>, 
+	typename polygon_t = boost::geometry::model::polygon<point_t>,
+	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>,
+	typename geometry_point_t = typename boost::geometry::point_type<polygon_t>::type
+	>
+static inline void correct(polygon_t const &input, multi_polygon_t &output, double remove_spike_min_area, correct_statistics &statistics)
+{
+	corrector<geometry_point_t, polygon_t, multi_polygon_t, correct_statistics> instrumented(remove_spike_min_area);
+	instrumented.correct(input, output);
+	statistics += instrumented.statistics();
 }
 
 template<
-	typename fill_function_t,
-	typename combine_function_t,
-	typename difference_function_t,
 	typename point_t = boost::geometry::model::d2::point_xy<double>, 
 	typename polygon_t = boost::geometry::model::polygon<point_t>,
-	typename ring_t = boost::geometry::model::ring<point_t>,
-	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>
+	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>,
+	typename geometry_point_t = typename boost::geometry::point_type<polygon_t>::type
 	>
-static inline void correct(multi_polygon_t const &input, multi_polygon_t &output, double remove_spike_min_area, fill_function_t const &fill, combine_function_t const &combine, difference_function_t const &difference)
+static inline void correct_odd_even(polygon_t const &input, multi_polygon_t &output, double remove_spike_min_area, correct_statistics &statistics)
 {
-	for(auto const &polygon: input)
-	{
-		multi_polygon_t new_polygons;
-		correct(polygon, new_polygons, remove_spike_min_area, fill, combine, difference);
-		combine(output, new_polygons);
-	}
+	impl::correct_workspace_t<polygon_t, correct_statistics> workspace;
+	impl::correct(input, output, remove_spike_min_area, 
+		impl::fill_odd_even<geometry_point_t, polygon_t, multi_polygon_t>(), 
+		[](multi_polygon_t &a, multi_polygon_t const &b) {
+			multi_polygon_t result;
+			boost::geometry::sym_difference(a, b, result);
+			a = std::move(result); 
+		},
+		boost::geometry::sym_difference<multi_polygon_t, multi_polygon_t, multi_polygon_t>,
+		workspace
+		);
+	statistics += workspace.statistics;
 }
 
+template<
+	typename point_t = boost::geometry::model::d2::point_xy<double>, 
+	typename polygon_t = boost::geometry::model::polygon<point_t>,
+	typename ring_t = boost::geometry::model::ring<point_t>,
+	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>,
+	typename geometry_polygon_t = typename boost::range_value<multi_polygon_t>::type,
+	typename geometry_point_t = typename boost::geometry::point_type<multi_polygon_t>::type
+	>
+static inline void correct(multi_polygon_t const &input, multi_polygon_t &output, double remove_spike_min_area, correct_statistics &statistics)
+{
+	corrector<geometry_point_t, geometry_polygon_t, multi_polygon_t, correct_statistics> instrumented(remove_spike_min_area);
+	instrumented.correct(input, output);
+	statistics += instrumented.statistics();
 }
 
 template<
 	typename point_t = boost::geometry::model::d2::point_xy<double>, 
 	typename polygon_t = boost::geometry::model::polygon<point_t>,
-	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>
+	typename ring_t = boost::geometry::model::ring<point_t>,
+	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>,
+	typename geometry_polygon_t = typename boost::range_value<multi_polygon_t>::type,
+	typename geometry_point_t = typename boost::geometry::point_type<multi_polygon_t>::type
 	>
-static inline void correct(polygon_t const &input, multi_polygon_t &output, double remove_spike_min_area = 0.0)
+static inline void correct_odd_even(multi_polygon_t const &input, multi_polygon_t &output, double remove_spike_min_area, correct_statistics &statistics)
 {
+	impl::correct_workspace_t<multi_polygon_t, correct_statistics> workspace;
 	impl::correct(input, output, remove_spike_min_area, 
-		impl::fill_non_zero_winding<point_t, polygon_t, multi_polygon_t>(), 
-		impl::result_combine_multiple<multi_polygon_t, multi_polygon_t>, 
-		boost::geometry::difference<multi_polygon_t, multi_polygon_t, multi_polygon_t>
+		impl::fill_odd_even<geometry_point_t, geometry_polygon_t, multi_polygon_t>(),
+		[](multi_polygon_t &a, multi_polygon_t const &b) {
+			multi_polygon_t result;
+			boost::geometry::sym_difference(a, b, result);
+			a = std::move(result); 
+		},
+		boost::geometry::sym_difference<multi_polygon_t, multi_polygon_t, multi_polygon_t>,
+		workspace
 		);
+	statistics += workspace.statistics;
 }
 
+// Correct a multi polygon in place, the storage of the input is reused for the output
 template<
 	typename point_t = boost::geometry::model::d2::point_xy<double>, 
 	typename polygon_t = boost::geometry::model::polygon<point_t>,
-	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>
+	typename ring_t = boost::geometry::model::ring<point_t>,
+	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>,
+	typename geometry_polygon_t = typename boost::range_value<multi_polygon_t>::type,
+	typename geometry_point_t = typename boost::geometry::point_type<multi_polygon_t>::type
 	>
-static inline void correct_odd_even(polygon_t const &input, multi_polygon_t &output, double remove_spike_min_area = 0.0)
+static inline void correct_inplace(multi_polygon_t &geometry, double remove_spike_min_area = 0.0)
 {
-	impl::correct(input, output, remove_spike_min_area, 
-		impl::fill_odd_even<point_t, polygon_t, multi_polygon_t>(), 
+	corrector<geometry_point_t, geometry_polygon_t, multi_polygon_t>(remove_spike_min_area).correct_inplace(geometry);
+}
+
+template<
+	typename point_t = boost::geometry::model::d2::point_xy<double>, 
+	typename polygon_t = boost::geometry::model::polygon<point_t>,
+	typename ring_t = boost::geometry::model::ring<point_t>,
+	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>,
+	typename geometry_polygon_t = typename boost::range_value<multi_polygon_t>::type,
+	typename geometry_point_t = typename boost::geometry::point_type<multi_polygon_t>::type
+	>
+static inline void correct_odd_even_inplace(multi_polygon_t &geometry, double remove_spike_min_area = 0.0)
+{
+	impl::correct_inplace(geometry, remove_spike_min_area, 
+		impl::fill_odd_even<geometry_point_t, geometry_polygon_t, multi_polygon_t>(),
 		[](multi_polygon_t &a, multi_polygon_t const &b) {
 			multi_polygon_t result;
 			boost::geometry::sym_difference(a, b, result);
@@ -534,22 +4262,23 @@ static inline void correct_odd_even(polygon_t const &input, multi_polygon_t &out
 		},
 		boost::geometry::sym_difference<multi_polygon_t, multi_polygon_t, multi_polygon_t>
 		);
-
 }
 
-
 template<
 	typename point_t = boost::geometry::model::d2::point_xy<double>, 
 	typename polygon_t = boost::geometry::model::polygon<point_t>,
 	typename ring_t = boost::geometry::model::ring<point_t>,
-	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>
+	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>,
+	typename geometry_polygon_t = typename boost::range_value<multi_polygon_t>::type,
+	typename geometry_point_t = typename boost::geometry::point_type<multi_polygon_t>::type
 	>
-static inline void correct(multi_polygon_t const &input, multi_polygon_t &output, double remove_spike_min_area = 0.0)
+static inline void correct(multi_polygon_t const &input, multi_polygon_t &output, double remove_spike_min_area, thread_pool &pool)
 {
 	impl::correct(input, output, remove_spike_min_area, 
-		impl::fill_non_zero_winding<point_t, polygon_t, multi_polygon_t>(),
+		impl::fill_non_zero_winding_direct<geometry_point_t, geometry_polygon_t, multi_polygon_t>(),
 		impl::result_combine_multiple<multi_polygon_t, multi_polygon_t>, 
-		boost::geometry::difference<multi_polygon_t, multi_polygon_t, multi_polygon_t>
+		boost::geometry::difference<multi_polygon_t, multi_polygon_t, multi_polygon_t>,
+		pool
 		);
 }
 
@@ -557,21 +4286,614 @@ template<
 	typename point_t = boost::geometry::model::d2::point_xy<double>, 
 	typename polygon_t = boost::geometry::model::polygon<point_t>,
 	typename ring_t = boost::geometry::model::ring<point_t>,
-	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>
+	typename multi_polygon_t = boost::geometry::model::multi_polygon<polygon_t>,
+	typename geometry_polygon_t = typename boost::range_value<multi_polygon_t>::type,
+	typename geometry_point_t = typename boost::geometry::point_type<multi_polygon_t>::type
 	>
-static inline void correct_odd_even(multi_polygon_t const &input, multi_polygon_t &output, double remove_spike_min_area = 0.0)
+static inline void correct_odd_even(multi_polygon_t const &input, multi_polygon_t &output, double remove_spike_min_area, thread_pool &pool)
 {
 	impl::correct(input, output, remove_spike_min_area, 
-		impl::fill_odd_even<point_t, polygon_t, multi_polygon_t>(),
+		impl::fill_odd_even<geometry_point_t, geometry_polygon_t, multi_polygon_t>(),
 		[](multi_polygon_t &a, multi_polygon_t const &b) {
 			multi_polygon_t result;
 			boost::geometry::sym_difference(a, b, result);
 			a = std::move(result); 
 		},
-		boost::geometry::sym_difference<multi_polygon_t, multi_polygon_t, multi_polygon_t>
+		boost::geometry::sym_difference<multi_polygon_t, multi_polygon_t, multi_polygon_t>,
+		pool
 		);
 }
 
+// Invalid or unsupported WKB input
+struct read_wkb_exception : public boost::geometry::exception
+{
+	std::string message;
+
+	explicit read_wkb_exception(std::string const &message)
+		: message("read_wkb: " + message)
+	{ }
+
+	char const *what() const noexcept override
+	{
+		return message.c_str();
+	}
+};
+
+namespace impl {
+
+enum wkb_type : std::uint32_t
+{
+	wkb_polygon = 3,
+	wkb_multi_polygon = 6
+};
+
+// Reader of WKB polygons and multi polygons, also accepting the Z and M variants of 
+// ISO WKB and EWKB. The coordinates are decoded directly into the point type and
+// coordinates other than x and y are skipped.
+class wkb_reader
+{
+	unsigned char const *p;
+	unsigned char const *end;
+
+	// Byte order and dimensions of the geometry being read
+	bool little_endian = true;
+	std::size_t dimensions = 2;
+
+	void require(std::size_t size)
+	{
+		if(std::size_t(end - p) < size)
+			throw read_wkb_exception("unexpected end of input");
+	}
+
+	std::uint64_t read_unsigned(std::size_t size)
+	{
+		require(size);
+		std::uint64_t value = 0;
+		for(std::size_t i = 0; i < size; ++i)
+			value |= std::uint64_t(p[little_endian ? i : size - 1 - i]) << (8 * i);
+		p += size;
+		return value;
+	}
+
+	std::uint32_t read_count()
+	{
+		return std::uint32_t(read_unsigned(4));
+	}
+
+	double read_double()
+	{
+		std::uint64_t bits = read_unsigned(8);
+		double value;
+		std::memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	// Read byte order and type of a geometry, the type is returned without dimensions
+	std::uint32_t read_header()
+	{
+		require(1);
+		little_endian = *p++ != 0;
+
+		std::uint32_t type = read_count();
+		dimensions = 2;
+
+		// EWKB flags for Z, M and SRID
+		if(type & 0x80000000u)
+			++dimensions;
+		if(type & 0x40000000u)
+			++dimensions;
+		if(type & 0x20000000u)
+			read_count();
+		type &= 0x0fffffffu;
+
+		// ISO WKB Z (1000), M (2000) and ZM (3000) types
+		if(type >= 1000 && type < 4000) {
+			dimensions += (type / 1000 == 3) ? 2 : 1;
+			type %= 1000;
+		}
+		return type;
+	}
+
+	template<typename ring_t>
+	void read_ring(ring_t &ring)
+	{
+		typedef typename boost::geometry::point_type<ring_t>::type point_t;
+		typedef typename boost::geometry::coordinate_type<point_t>::type coordinate_t;
+
+		std::uint32_t count = read_count();
+		require(std::size_t(count) * dimensions * 8);
+		ring.reserve(count);
+
+		for(std::uint32_t i = 0; i < count; ++i) {
+			point_t point;
+			boost::geometry::set<0>(point, coordinate<coordinate_t>(read_double()));
+			boost::geometry::set<1>(point, coordinate<coordinate_t>(read_double()));
+			p += (dimensions - 2) * 8;
+			ring.push_back(point);
+		}
+	}
+
+	template<typename polygon_t>
+	void read_polygon_rings(polygon_t &polygon)
+	{
+		std::uint32_t count = read_count();
+		if(count == 0)
+			return;
+
+		read_ring(polygon.outer());
+		require(std::size_t(count - 1) * 4);
+		polygon.inners().resize(count - 1);
+		for(auto &inner: polygon.inners())
+			read_ring(inner);
+	}
+
+	template<typename polygon_t>
+	void read_polygon(polygon_t &polygon)
+	{
+		if(read_header() != wkb_polygon)
+			throw read_wkb_exception("polygon expected");
+		read_polygon_rings(polygon);
+	}
+
+	template<typename coordinate_t>
+	static inline coordinate_t coordinate(double v)
+	{
+		if(std::is_integral<coordinate_t>::value)
+			return coordinate_t(std::llround(v));
+		return coordinate_t(v);
+	}
+
+	void finish()
+	{
+		if(p != end)
+			throw read_wkb_exception("unexpected data after geometry");
+	}
+
+public:
+	wkb_reader(unsigned char const *data, std::size_t size)
+		: p(data), end(data + size)
+	{ }
+
+	template<typename polygon_t>
+	void read(polygon_t &polygon, boost::geometry::polygon_tag)
+	{
+		read_polygon(polygon);
+		finish();
+	}
+
+	// A polygon is read as multi polygon with a single polygon, an empty polygon as empty multi polygon
+	template<typename multi_polygon_t>
+	void read(multi_polygon_t &multi_polygon, boost::geometry::multi_polygon_tag)
+	{
+		std::uint32_t type = read_header();
+		if(type == wkb_polygon) {
+			typename boost::range_value<multi_polygon_t>::type polygon;
+			read_polygon_rings(polygon);
+			if(!boost::geometry::is_empty(polygon))
+				multi_polygon.push_back(std::move(polygon));
+		} else if(type == wkb_multi_polygon) {
+			std::uint32_t count = read_count();
+			require(std::size_t(count) * 9);
+			multi_polygon.resize(count);
+			for(auto &polygon: multi_polygon)
+				read_polygon(polygon);
+		} else {
+			throw read_wkb_exception("polygon or multi polygon expected");
+		}
+		finish();
+	}
+};
+
+// Writer of little endian WKB polygons and multi polygons
+class wkb_writer
+{
+	std::vector<unsigned char> &output;
+
+	void write_unsigned(std::uint64_t value, std::size_t size)
+	{
+		for(std::size_t i = 0; i < size; ++i)
+			output.push_back((unsigned char)(value >> (8 * i)));
+	}
+
+	void write_header(std::uint32_t type)
+	{
+		output.push_back(1);
+		write_unsigned(type, 4);
+	}
+
+	void write_double(double value)
+	{
+		std::uint64_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		write_unsigned(bits, 8);
+	}
+
+	template<typename ring_t>
+	void write_ring(ring_t const &ring)
+	{
+		write_unsigned(boost::size(ring), 4);
+		for(auto const &point: ring) {
+			write_double(double(boost::geometry::get<0>(point)));
+			write_double(double(boost::geometry::get<1>(point)));
+		}
+	}
+
+public:
+	explicit wkb_writer(std::vector<unsigned char> &output)
+		: output(output)
+	{ }
+
+	template<typename polygon_t>
+	void write(polygon_t const &polygon, boost::geometry::polygon_tag)
+	{
+		write_header(wkb_polygon);
+		if(boost::geometry::is_empty(polygon)) {
+			write_unsigned(0, 4);
+			return;
+		}
+
+		write_unsigned(1 + boost::size(polygon.inners()), 4);
+		write_ring(polygon.outer());
+		for(auto const &inner: polygon.inners())
+			write_ring(inner);
+	}
+
+	template<typename multi_polygon_t>
+	void write(multi_polygon_t const &multi_polygon, boost::geometry::multi_polygon_tag)
+	{
+		write_header(wkb_multi_polygon);
+		write_unsigned(boost::size(multi_polygon), 4);
+		for(auto const &polygon: multi_polygon)
+			write(polygon, boost::geometry::polygon_tag());
+	}
+};
+
+}
+
+// Read a WKB polygon into a polygon, or a WKB polygon or multi polygon into a multi polygon.
+// Throws read_wkb_exception on invalid input.
+template<typename geometry_t>
+static inline void read_wkb(unsigned char const *data, std::size_t size, geometry_t &geometry)
+{
+	impl::wkb_reader(data, size).read(geometry, typename boost::geometry::tag<geometry_t>::type());
+}
+
+// Append the WKB of a polygon or multi polygon to the output
+template<typename geometry_t>
+static inline void write_wkb(geometry_t const &geometry, std::vector<unsigned char> &output)
+{
+	impl::wkb_writer(output).write(geometry, typename boost::geometry::tag<geometry_t>::type());
+}
+
+// Correct a WKB polygon or multi polygon and append the WKB of the corrected multi polygon
+// to the output. The geometry is decoded into the multi polygon type and corrected in place.
+template<
+	typename multi_polygon_t = boost::geometry::model::multi_polygon<boost::geometry::model::polygon<boost::geometry::model::d2::point_xy<double>>>
+	>
+static inline void correct_wkb(unsigned char const *data, std::size_t size, std::vector<unsigned char> &output, double remove_spike_min_area = 0.0)
+{
+	multi_polygon_t geometry;
+	read_wkb(data, size, geometry);
+
+	if(geometry.size() == 1) {
+		multi_polygon_t result;
+		correct(std::move(geometry.front()), result, remove_spike_min_area);
+		write_wkb(result, output);
+	} else {
+		correct_inplace(geometry, remove_spike_min_area);
+		write_wkb(geometry, output);
+	}
+}
+
+// Invalid cache data
+struct read_cache_exception : public boost::geometry::exception
+{
+	std::string message;
+
+	explicit read_cache_exception(std::string const &message)
+		: message("read_cache: " + message)
+	{ }
+
+	char const *what() const noexcept override
+	{
+		return message.c_str();
+	}
+};
+
+// Rule used to fill the corrected rings
+enum class fill_rule
+{
+	non_zero_winding,
+	odd_even
+};
+
+namespace impl {
+
+static inline std::uint64_t cache_rotate(std::uint64_t x, int r)
+{
+	return (x << r) | (x >> (64 - r));
+}
+
+// Hash of a byte buffer, 8 bytes at a time using the mixing of murmur3
+static inline std::uint64_t cache_hash(unsigned char const *data, std::size_t size)
+{
+	std::uint64_t h = 0x9e3779b97f4a7c15ull ^ size;
+	auto mix = [&h](std::uint64_t k) {
+		k *= 0x87c37b91114253d5ull;
+		k = cache_rotate(k, 31);
+		k *= 0x4cf5ad432745937full;
+		h ^= k;
+		h = cache_rotate(h, 27) * 5 + 0x52dce729;
+	};
+
+	std::size_t i = 0;
+	for(; i + 8 <= size; i += 8) {
+		std::uint64_t k;
+		std::memcpy(&k, data + i, 8);
+		mix(k);
+	}
+	if(i < size) {
+		std::uint64_t k = 0;
+		std::memcpy(&k, data + i, size - i);
+		mix(k);
+	}
+
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdull;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ull;
+	h ^= h >> 33;
+	return h;
+}
+
+}
+
+// Cache of corrected geometries, for input which is corrected repeatedly. The key of an entry
+// is the fill rule, remove_spike_min_area and the WKB of the input, the corrected multi polygon
+// is stored as WKB. Entries are found by a hash of the key and the key is compared on a hit, so
+// a hash collision never returns the result of another geometry. The least recently used
+// entries are removed when the size of the entries exceeds max_bytes.
+//
+// The cache can be used from multiple threads. Only finding and inserting an entry is done
+// under the lock, hashing, decoding the result and the correction itself are not.
+//
+// The entries can be written to a buffer and read back on restart. When read from a memory 
+// mapped file, the entries refer to the mapped data, which must stay mapped while the cache is used.
+class correct_cache
+{
+	struct entry
+	{
+		std::uint64_t hash;
+		bool valid;
+		std::vector<unsigned char> storage;
+		unsigned char const *key;
+		std::size_t key_size;
+		unsigned char const *result;
+		std::size_t result_size;
+
+		std::size_t bytes() const
+		{
+			return key_size + result_size + sizeof(entry);
+		}
+	};
+
+	typedef std::list<std::shared_ptr<entry const>> entry_list;
+
+	std::size_t max_bytes;
+	std::size_t used_bytes = 0;
+	std::size_t hit_count = 0;
+	std::size_t miss_count = 0;
+
+	// Most recently used entry first
+	entry_list entries;
+	std::unordered_map<std::uint64_t, entry_list::iterator> index;
+	mutable std::mutex mutex;
+
+	template<typename geometry_t>
+	static void make_key(geometry_t const &input, fill_rule rule, double remove_spike_min_area, std::vector<unsigned char> &key)
+	{
+		std::uint64_t bits;
+		std::memcpy(&bits, &remove_spike_min_area, sizeof(bits));
+
+		key.clear();
+		key.push_back((unsigned char)rule);
+		write_unsigned(key, bits, 8);
+		write_wkb(input, key);
+	}
+
+	std::shared_ptr<entry const> find(std::uint64_t hash, std::vector<unsigned char> const &key)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto i = index.find(hash);
+		if(i == index.end() || (*i->second)->key_size != key.size() || std::memcmp((*i->second)->key, key.data(), key.size()) != 0) {
+			++miss_count;
+			return nullptr;
+		}
+
+		++hit_count;
+		entries.splice(entries.begin(), entries, i->second);
+		return entries.front();
+	}
+
+	// Insert as most recently used entry, replacing the entry with the same hash
+	void insert(std::shared_ptr<entry const> e)
+	{
+		if(e->bytes() > max_bytes)
+			return;
+
+		auto i = index.find(e->hash);
+		if(i != index.end()) {
+			used_bytes -= (*i->second)->bytes();
+			entries.erase(i->second);
+			index.erase(i);
+		}
+
+		used_bytes += e->bytes();
+		entries.push_front(std::move(e));
+		index.emplace(entries.front()->hash, entries.begin());
+
+		while(used_bytes > max_bytes) {
+			used_bytes -= entries.back()->bytes();
+			index.erase(entries.back()->hash);
+			entries.pop_back();
+		}
+	}
+
+	static void write_unsigned(std::vector<unsigned char> &output, std::uint64_t value, std::size_t size)
+	{
+		for(std::size_t i = 0; i < size; ++i)
+			output.push_back((unsigned char)(value >> (8 * i)));
+	}
+
+	static std::uint64_t read_unsigned(unsigned char const *&p, unsigned char const *end, std::size_t size)
+	{
+		if(std::size_t(end - p) < size)
+			throw read_cache_exception("unexpected end of input");
+
+		std::uint64_t value = 0;
+		for(std::size_t i = 0; i < size; ++i)
+			value |= std::uint64_t(p[i]) << (8 * i);
+		p += size;
+		return value;
+	}
+
+	static constexpr char const *magic()
+	{
+		return "BGCACHE1";
+	}
+
+public:
+	explicit correct_cache(std::size_t max_bytes)
+		: max_bytes(max_bytes)
+	{ }
+
+	correct_cache(correct_cache const &) = delete;
+	correct_cache &operator=(correct_cache const &) = delete;
+
+	// Find the correction of the input, or correct it with correct(input, result) and store
+	// the result. The corrected multi polygon is appended to the output.
+	template<typename geometry_t, typename multi_polygon_t, typename correct_function_t>
+	bool apply(geometry_t const &input, multi_polygon_t &output, fill_rule rule, double remove_spike_min_area, correct_function_t const &correct)
+	{
+		auto e = std::make_shared<entry>();
+		make_key(input, rule, remove_spike_min_area, e->storage);
+		e->hash = impl::cache_hash(e->storage.data(), e->storage.size());
+
+		multi_polygon_t result;
+		bool valid;
+		if(auto cached = find(e->hash, e->storage)) {
+			read_wkb(cached->result, cached->result_size, result);
+			valid = cached->valid;
+		} else {
+			valid = e->valid = correct(input, result);
+			e->key_size = e->storage.size();
+			write_wkb(result, e->storage);
+			e->result_size = e->storage.size() - e->key_size;
+			e->key = e->storage.data();
+			e->result = e->storage.data() + e->key_size;
+
+			std::lock_guard<std::mutex> lock(mutex);
+			insert(std::move(e));
+		}
+
+		output.insert(output.end(), std::make_move_iterator(result.begin()), std::make_move_iterator(result.end()));
+		return valid;
+	}
+
+	template<typename geometry_t, typename multi_polygon_t>
+	bool correct(geometry_t const &input, multi_polygon_t &output, double remove_spike_min_area = 0.0)
+	{
+		return apply(input, output, fill_rule::non_zero_winding, remove_spike_min_area, [remove_spike_min_area](geometry_t const &source, multi_polygon_t &result) {
+			if(impl::copy_if_valid(source, result, remove_spike_min_area))
+				return true;
+			geometry::correct(source, result, remove_spike_min_area);
+			return false;
+		});
+	}
+
+	template<typename geometry_t, typename multi_polygon_t>
+	bool correct_odd_even(geometry_t const &input, multi_polygon_t &output, double remove_spike_min_area = 0.0)
+	{
+		return apply(input, output, fill_rule::odd_even, remove_spike_min_area, [remove_spike_min_area](geometry_t const &source, multi_polygon_t &result) {
+			if(impl::copy_if_valid(source, result, remove_spike_min_area))
+				return true;
+			geometry::correct_odd_even(source, result, remove_spike_min_area);
+			return false;
+		});
+	}
+
+	// Append the entries to the output, least recently used first
+	void write(std::vector<unsigned char> &output) const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		output.insert(output.end(), magic(), magic() + 8);
+		for(auto i = entries.rbegin(); i != entries.rend(); ++i) {
+			entry const &e = **i;
+			write_unsigned(output, e.hash, 8);
+			output.push_back(e.valid ? 1 : 0);
+			write_unsigned(output, e.key_size, 8);
+			write_unsigned(output, e.result_size, 8);
+			output.insert(output.end(), e.key, e.key + e.key_size);
+			output.insert(output.end(), e.result, e.result + e.result_size);
+		}
+	}
+
+	// Insert the entries written by write. The entries refer to the data, which is not copied.
+	// Throws read_cache_exception on invalid data.
+	void read(unsigned char const *data, std::size_t size)
+	{
+		unsigned char const *p = data, *end = data + size;
+		if(size < 8 || std::memcmp(data, magic(), 8) != 0)
+			throw read_cache_exception("cache data expected");
+		p += 8;
+
+		std::vector<std::shared_ptr<entry const>> read_entries;
+		while(p != end) {
+			auto e = std::make_shared<entry>();
+			e->hash = read_unsigned(p, end, 8);
+			e->valid = read_unsigned(p, end, 1) != 0;
+			e->key_size = read_unsigned(p, end, 8);
+			e->result_size = read_unsigned(p, end, 8);
+			if(std::size_t(end - p) < e->key_size || std::size_t(end - p) - e->key_size < e->result_size)
+				throw read_cache_exception("unexpected end of input");
+
+			e->key = p;
+			e->result = p + e->key_size;
+			p += e->key_size + e->result_size;
+			read_entries.push_back(std::move(e));
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+		for(auto &e: read_entries)
+			insert(std::move(e));
+	}
+
+	// Size of the entries in bytes
+	std::size_t bytes() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return used_bytes;
+	}
+
+	std::size_t size() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return entries.size();
+	}
+
+	std::size_t hits() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return hit_count;
+	}
+
+	std::size_t misses() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return miss_count;
+	}
+};
+
 }
 
 #endif
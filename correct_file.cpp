@@ -0,0 +1,503 @@
+#include "correct.hpp"
+
+#include <boost/format.hpp>
+
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Correct a file with one WKT or hex encoded WKB polygon or multi polygon per line. The 
+// input is memory mapped, the lines are corrected on worker threads and the corrected 
+// multi polygons are written in the order of the input, one per line, in the format of
+// the input line. With a cache file, lines corrected in a previous run are taken from
+// the cache, which is memory mapped on start and rewritten when done.
+//
+// correct_file <input> <output> [remove_spike_min_area] [threads] [cache]
+
+namespace bg = boost::geometry;
+typedef bg::model::d2::point_xy<double> point;
+typedef bg::model::ring<point> ring;
+typedef bg::model::polygon<point> polygon;
+typedef bg::model::multi_polygon<polygon> multi_polygon;
+
+// Maximum size of the cached keys and results
+static std::size_t const cache_bytes = std::size_t(1) << 30;
+
+// Parser of WKT polygons and multi polygons, reading the coordinates directly from the
+// mapped input
+class wkt_parser
+{
+	char const *p;
+	char const *end;
+
+	void skip_space()
+	{
+		while(p != end && (*p == ' ' || *p == '\t' || *p == '\r'))
+			++p;
+	}
+
+	bool token(char c)
+	{
+		skip_space();
+		if(p == end || *p != c)
+			return false;
+		++p;
+		return true;
+	}
+
+	bool keyword(char const *word)
+	{
+		skip_space();
+		char const *q = p;
+		for(; *word; ++word, ++q) {
+			if(q == end || std::toupper(static_cast<unsigned char>(*q)) != *word)
+				return false;
+		}
+		p = q;
+		return true;
+	}
+
+	bool number(double &value)
+	{
+		skip_space();
+		auto result = std::from_chars(p, end, value);
+		if(result.ec != std::errc())
+			return false;
+		p = result.ptr;
+		return true;
+	}
+
+	// Coordinates after the first two are ignored
+	bool parse_point(point &result)
+	{
+		double x, y, ignored;
+		if(!number(x) || !number(y))
+			return false;
+		while(number(ignored));
+		result = point(x, y);
+		return true;
+	}
+
+	bool parse_ring(ring &result)
+	{
+		if(!token('('))
+			return false;
+		do {
+			point pt;
+			if(!parse_point(pt))
+				return false;
+			result.push_back(pt);
+		} while(token(','));
+		return token(')');
+	}
+
+	bool parse_polygon(polygon &result)
+	{
+		if(keyword("EMPTY"))
+			return true;
+		if(!token('(') || !parse_ring(result.outer()))
+			return false;
+		while(token(',')) {
+			result.inners().emplace_back();
+			if(!parse_ring(result.inners().back()))
+				return false;
+		}
+		return token(')');
+	}
+
+	bool parse_multi_polygon(multi_polygon &result)
+	{
+		if(keyword("EMPTY"))
+			return true;
+		if(!token('('))
+			return false;
+		do {
+			result.emplace_back();
+			if(!parse_polygon(result.back()))
+				return false;
+		} while(token(','));
+		return token(')');
+	}
+
+public:
+	// Parse the text into the multi polygon, a polygon is returned as multi polygon
+	// with a single polygon
+	bool parse(std::string_view text, multi_polygon &result)
+	{
+		p = text.data();
+		end = text.data() + text.size();
+
+		bool parsed = false;
+		if(keyword("MULTIPOLYGON"))
+			parsed = parse_multi_polygon(result);
+		else if(keyword("POLYGON")) {
+			result.emplace_back();
+			parsed = parse_polygon(result.back());
+		}
+
+		skip_space();
+		return parsed && p == end;
+	}
+};
+
+// Memory mapped input file
+class mapped_file
+{
+	char const *data = nullptr;
+	std::size_t length = 0;
+
+public:
+	explicit mapped_file(char const *filename)
+	{
+		int fd = ::open(filename, O_RDONLY);
+		if(fd < 0)
+			throw std::runtime_error(std::string("Unable to open ") + filename);
+
+		struct stat st;
+		if(::fstat(fd, &st) == 0 && st.st_size > 0) {
+			length = std::size_t(st.st_size);
+			void *mapped = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+			if(mapped != MAP_FAILED) {
+				data = static_cast<char const *>(mapped);
+				::madvise(mapped, length, MADV_SEQUENTIAL);
+			}
+		}
+		::close(fd);
+
+		if(length > 0 && data == nullptr)
+			throw std::runtime_error(std::string("Unable to map ") + filename);
+	}
+
+	mapped_file(mapped_file const &) = delete;
+	mapped_file &operator=(mapped_file const &) = delete;
+
+	~mapped_file()
+	{
+		if(data)
+			::munmap(const_cast<char *>(data), length);
+	}
+
+	std::string_view text() const
+	{
+		return std::string_view(data, length);
+	}
+
+	unsigned char const *bytes() const
+	{
+		return reinterpret_cast<unsigned char const *>(data);
+	}
+
+	std::size_t size() const
+	{
+		return length;
+	}
+};
+
+// Queue with a maximum size, push waits while the queue is full
+template<typename T>
+class bounded_queue
+{
+	std::deque<T> items;
+	std::size_t capacity;
+	bool closed = false;
+	std::mutex mutex;
+	std::condition_variable not_full, not_empty;
+
+public:
+	explicit bounded_queue(std::size_t capacity)
+		: capacity(capacity)
+	{ }
+
+	void push(T item)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		not_full.wait(lock, [this]() { return items.size() < capacity; });
+		items.push_back(std::move(item));
+		not_empty.notify_one();
+	}
+
+	// Returns false when the queue is closed and empty
+	bool pop(T &item)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		not_empty.wait(lock, [this]() { return closed || !items.empty(); });
+		if(items.empty())
+			return false;
+		item = std::move(items.front());
+		items.pop_front();
+		not_full.notify_one();
+		return true;
+	}
+
+	void close()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		closed = true;
+		not_empty.notify_all();
+	}
+};
+
+// Corrected lines waiting to be written, at most window lines ahead of the line
+// written last. Lines are written in the order of the input.
+class ordered_writer
+{
+	std::ostream &out;
+	std::vector<std::string> lines;
+	std::vector<bool> ready;
+	std::size_t written = 0;
+	std::size_t total = std::size_t(-1);
+	std::mutex mutex;
+	std::condition_variable condition;
+
+public:
+	ordered_writer(std::ostream &out, std::size_t window)
+		: out(out), lines(window), ready(window, false)
+	{ }
+
+	void put(std::size_t index, std::string &&line)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		condition.wait(lock, [this, index]() { return index < written + lines.size(); });
+		lines[index % lines.size()] = std::move(line);
+		ready[index % lines.size()] = true;
+		condition.notify_all();
+	}
+
+	// Number of lines, known once the input is read
+	void finish(std::size_t count)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		total = count;
+		condition.notify_all();
+	}
+
+	// Write the lines until all lines are written
+	void write()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		while(true) {
+			std::size_t slot = written % lines.size();
+			condition.wait(lock, [this, slot]() { return ready[slot] || written == total; });
+			if(written == total)
+				break;
+
+			std::string line = std::move(lines[slot]);
+			ready[slot] = false;
+			++written;
+			condition.notify_all();
+
+			lock.unlock();
+			out << line << '\n';
+			lock.lock();
+		}
+	}
+};
+
+// Hex encoded WKB starts with the byte order, 00 or 01
+static bool is_hex_wkb(std::string_view text)
+{
+	return !text.empty() && text.front() == '0';
+}
+
+static bool hex_decode(std::string_view text, std::vector<unsigned char> &bytes)
+{
+	auto nibble = [](char c) {
+		if(c >= '0' && c <= '9') return c - '0';
+		if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+		if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+		return -1;
+	};
+
+	bytes.clear();
+	if(text.size() % 2 != 0)
+		return false;
+	for(std::size_t i = 0; i < text.size(); i += 2) {
+		int high = nibble(text[i]), low = nibble(text[i + 1]);
+		if(high < 0 || low < 0)
+			return false;
+		bytes.push_back((unsigned char)(high * 16 + low));
+	}
+	return true;
+}
+
+static void hex_encode(std::vector<unsigned char> const &bytes, std::string &text)
+{
+	char const *digits = "0123456789ABCDEF";
+	text.clear();
+	for(auto b: bytes) {
+		text.push_back(digits[b >> 4]);
+		text.push_back(digits[b & 15]);
+	}
+}
+
+struct job
+{
+	std::size_t index;
+	std::string_view text;
+};
+
+int main(int argc, char *argv[])
+{
+	if(argc < 3) {
+		std::cerr << "Usage: " << argv[0] << " <input> <output> [remove_spike_min_area] [threads] [cache]" << std::endl;
+		return 1;
+	}
+
+	double remove_spike_min_area = argc > 3 ? std::atof(argv[3]) : 0.0;
+	std::size_t thread_count = argc > 4 ? std::size_t(std::atoi(argv[4])) : std::thread::hardware_concurrency();
+	thread_count = std::max<std::size_t>(thread_count, 1);
+	char const *cache_filename = argc > 5 ? argv[5] : nullptr;
+
+	try {
+		mapped_file input(argv[1]);
+
+		// The cached entries refer to the mapped cache file, so it is mapped as long as the cache is used
+		std::unique_ptr<mapped_file> cache_file;
+		std::unique_ptr<geometry::correct_cache> cache;
+		if(cache_filename) {
+			cache.reset(new geometry::correct_cache(cache_bytes));
+			if(::access(cache_filename, F_OK) == 0) {
+				cache_file.reset(new mapped_file(cache_filename));
+				if(cache_file->size() > 0)
+					cache->read(cache_file->bytes(), cache_file->size());
+			}
+		}
+
+		std::ofstream output(argv[2], std::ios::binary);
+		if(!output)
+			throw std::runtime_error(std::string("Unable to open ") + argv[2]);
+
+		auto start = std::chrono::steady_clock::now();
+
+		bounded_queue<job> jobs(4 * thread_count);
+		ordered_writer writer(output, 16 * thread_count);
+		std::atomic<std::size_t> vertices(0), errors(0);
+
+		// Every worker keeps its own corrector, so the buffers are reused between lines
+		std::vector<std::thread> workers;
+		for(std::size_t i = 0; i < thread_count; ++i) {
+			workers.emplace_back([&]() {
+				geometry::corrector<point> corrector(remove_spike_min_area);
+				corrector.set_check_valid(true);
+				wkt_parser parser;
+				std::ostringstream out;
+				out.precision(std::numeric_limits<double>::max_digits10);
+				std::vector<unsigned char> wkb;
+
+				job j;
+				while(jobs.pop(j)) {
+					multi_polygon geometry, result;
+					if(j.text.empty()) {
+						writer.put(j.index, std::string());
+						continue;
+					}
+
+					bool hex = is_hex_wkb(j.text);
+					bool parsed = false;
+					if(hex) {
+						try {
+							parsed = hex_decode(j.text, wkb);
+							if(parsed)
+								geometry::read_wkb(wkb.data(), wkb.size(), geometry);
+						} catch(geometry::read_wkb_exception const &) {
+							parsed = false;
+						}
+					} else {
+						parsed = parser.parse(j.text, geometry);
+					}
+
+					if(parsed) {
+						vertices += bg::num_points(geometry);
+						auto correct = [&corrector](multi_polygon const &input, multi_polygon &output) {
+							if(input.size() == 1)
+								return corrector.correct(input.front(), output);
+							return corrector.correct(input, output);
+						};
+
+						if(cache)
+							cache->apply(geometry, result, geometry::fill_rule::non_zero_winding, remove_spike_min_area, correct);
+						else
+							correct(geometry, result);
+					} else {
+						std::cerr << "Unable to parse line " << (j.index + 1) << std::endl;
+						++errors;
+					}
+
+					std::string line;
+					if(hex) {
+						wkb.clear();
+						geometry::write_wkb(result, wkb);
+						hex_encode(wkb, line);
+					} else {
+						out.str(std::string());
+						out << bg::wkt(result);
+						line = out.str();
+					}
+					writer.put(j.index, std::move(line));
+				}
+			});
+		}
+
+		// Split the input into lines
+		std::size_t count = 0;
+		std::thread reader([&]() {
+			std::string_view text = input.text();
+			while(!text.empty()) {
+				std::size_t length = text.find('\n');
+				std::string_view line = text.substr(0, length);
+				if(!line.empty() && line.back() == '\r')
+					line.remove_suffix(1);
+
+				jobs.push(job{ count++, line });
+				text.remove_prefix(length == std::string_view::npos ? text.size() : length + 1);
+			}
+			jobs.close();
+			writer.finish(count);
+		});
+
+		writer.write();
+		reader.join();
+		for(auto &worker: workers)
+			worker.join();
+
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		std::cerr << boost::format("%d geometries, %d vertices, %d errors in %.3f s: %.0f geometries/s, %.0f vertices/s")
+			% count % vertices.load() % errors.load() % elapsed.count() % (count / elapsed.count()) % (vertices / elapsed.count()) << std::endl;
+
+		// Write the cache next to the mapped cache file and replace it when complete
+		if(cache) {
+			std::cerr << boost::format("%d cache hits, %d cache misses, %d cached geometries") 
+				% cache->hits() % cache->misses() % cache->size() << std::endl;
+
+			std::vector<unsigned char> bytes;
+			cache->write(bytes);
+			std::string temporary = std::string(cache_filename) + ".tmp";
+			std::ofstream cache_output(temporary, std::ios::binary);
+			cache_output.write(reinterpret_cast<char const *>(bytes.data()), std::streamsize(bytes.size()));
+			cache_output.close();
+			if(!cache_output || std::rename(temporary.c_str(), cache_filename) != 0)
+				throw std::runtime_error(std::string("Unable to write ") + cache_filename);
+		}
+
+		return errors == 0 ? 0 : 2;
+	} catch(std::exception const &e) {
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+}
@@ -106,6 +106,650 @@ void random_test()
 	std::cout << "Done" << std::endl;
 }
 
+void parallel_test()
+{
+	std::default_random_engine generator;
+  	std::uniform_real_distribution<double> distribution(0.0,1.0);
+
+	// Multi polygon of overlapping random polygons
+	multi_polygon input;
+	for(std::size_t run = 0; run < 100; ++run) {
+		polygon poly;
+		for(std::size_t i = 0; i < (unsigned int)(5 + distribution(generator) * 20); ++i) {
+			poly.outer().push_back( { run * 0.1 + distribution(generator), distribution(generator) } );
+		}
+		poly.outer().push_back( poly.outer().front() );
+		input.push_back(poly);
+	}
+
+	double remove_spike_threshold = 1E-12;
+	geometry::thread_pool pool(4);
+
+	auto to_string = [](multi_polygon const &mp) {
+		std::ostringstream out;
+		out << boost::geometry::wkt(mp);
+		return out.str();
+	};
+
+	multi_polygon serial, parallel;
+	geometry::correct(input, serial, remove_spike_threshold);
+	geometry::correct(input, parallel, remove_spike_threshold, pool);
+
+	if(to_string(serial) == to_string(parallel))
+		std::cout << "Parallel correct is equal to serial correct" << std::endl;
+	else
+		std::cout << "Parallel correct is not equal to serial correct" << std::endl;
+
+	multi_polygon serial_odd_even, parallel_odd_even;
+	geometry::correct_odd_even(input, serial_odd_even, remove_spike_threshold);
+	geometry::correct_odd_even(input, parallel_odd_even, remove_spike_threshold, pool);
+
+	if(to_string(serial_odd_even) == to_string(parallel_odd_even))
+		std::cout << "Parallel correct_odd_even is equal to serial correct_odd_even" << std::endl;
+	else
+		std::cout << "Parallel correct_odd_even is not equal to serial correct_odd_even" << std::endl;
+
+	// Polygon with overlapping random inners
+	polygon poly;
+	boost::geometry::read_wkt("POLYGON((0 0, 0 10, 10 10, 10 0, 0 0))", poly);
+	for(std::size_t run = 0; run < 100; ++run) {
+		poly.inners().emplace_back();
+		for(std::size_t i = 0; i < (unsigned int)(5 + distribution(generator) * 20); ++i) {
+			poly.inners().back().push_back( { run * 0.09 + distribution(generator), 1 + 8 * distribution(generator) } );
+		}
+		poly.inners().back().push_back( poly.inners().back().front() );
+	}
+
+	multi_polygon serial_poly, parallel_poly;
+	geometry::correct(poly, serial_poly, remove_spike_threshold);
+	geometry::correct(poly, parallel_poly, remove_spike_threshold, pool);
+
+	if(to_string(serial_poly) == to_string(parallel_poly))
+		std::cout << "Parallel polygon correct is equal to serial polygon correct" << std::endl;
+	else
+		std::cout << "Parallel polygon correct is not equal to serial polygon correct" << std::endl;
+}
+
+void batch_test()
+{
+	std::default_random_engine generator;
+  	std::uniform_real_distribution<double> distribution(0.0,1.0);
+
+	std::vector<polygon> input(100);
+	for(auto &poly: input) {
+		for(std::size_t i = 0; i < (unsigned int)(5 + distribution(generator) * 20); ++i) {
+			poly.outer().push_back( { distribution(generator), distribution(generator) } );
+		}
+		poly.outer().push_back( poly.outer().front() );
+	}
+
+	double remove_spike_threshold = 1E-12;
+
+	// Reuse the buffers of the correction from an arena for all polygons
+	std::pmr::monotonic_buffer_resource arena;
+	geometry::corrector<point> corrector(remove_spike_threshold, &arena);
+
+	std::vector<multi_polygon> batch;
+	corrector.correct_batch(input, std::back_inserter(batch));
+
+	std::vector<multi_polygon> single;
+	geometry::correct_batch(input, std::back_inserter(single), remove_spike_threshold);
+
+	bool equal = batch.size() == input.size() && single.size() == input.size();
+	for(std::size_t i = 0; equal && i < input.size(); ++i) {
+		multi_polygon result;
+		geometry::correct(input[i], result, remove_spike_threshold);
+
+		std::ostringstream expected, actual, actual_single;
+		expected << boost::geometry::wkt(result);
+		actual << boost::geometry::wkt(batch[i]);
+		actual_single << boost::geometry::wkt(single[i]);
+		equal = expected.str() == actual.str() && expected.str() == actual_single.str();
+	}
+
+	if(equal)
+		std::cout << "Batch correct is equal to single correct" << std::endl;
+	else
+		std::cout << "Batch correct is not equal to single correct" << std::endl;
+}
+
+void fast_path_test()
+{
+	geometry::corrector<point> corrector(1E-12);
+	corrector.set_check_valid(true);
+
+	polygon valid;
+	boost::geometry::read_wkt("POLYGON((0 0, 0 10, 10 10, 10 0, 0 0), (2 2, 4 2, 4 4, 2 4, 2 2), (6 6, 8 6, 8 8, 6 8, 6 6))", valid);
+	multi_polygon result;
+	if(corrector.correct(valid, result) && boost::geometry::equals(valid, result))
+		std::cout << "Valid polygon is copied to output" << std::endl;
+	else
+		std::cout << "Valid polygon is not copied to output" << std::endl;
+
+	polygon nested;
+	boost::geometry::read_wkt("POLYGON((0 0, 0 10, 10 10, 10 0, 0 0), (2 2, 8 2, 8 8, 2 8, 2 2), (3 3, 6 3, 6 6, 3 6, 3 3))", nested);
+	multi_polygon nested_result;
+	if(!corrector.correct(nested, nested_result))
+		std::cout << "Polygon with nested inners is corrected" << std::endl;
+	else
+		std::cout << "Polygon with nested inners is not corrected" << std::endl;
+}
+
+void inplace_test()
+{
+	std::default_random_engine generator;
+  	std::uniform_real_distribution<double> distribution(0.0,1.0);
+
+	multi_polygon input;
+	for(std::size_t run = 0; run < 20; ++run) {
+		polygon poly;
+		for(std::size_t i = 0; i < (unsigned int)(5 + distribution(generator) * 20); ++i) {
+			poly.outer().push_back( { run * 0.2 + distribution(generator), distribution(generator) } );
+		}
+		poly.outer().push_back( poly.outer().front() );
+		input.push_back(poly);
+	}
+
+	double remove_spike_threshold = 1E-12;
+
+	auto to_string = [](multi_polygon const &mp) {
+		std::ostringstream out;
+		out << boost::geometry::wkt(mp);
+		return out.str();
+	};
+
+	bool equal = true;
+	for(auto const &poly: input) {
+		multi_polygon expected, actual;
+		geometry::correct(poly, expected, remove_spike_threshold);
+		geometry::correct(polygon(poly), actual, remove_spike_threshold);
+		equal = equal && to_string(expected) == to_string(actual);
+	}
+
+	multi_polygon expected, actual = input;
+	geometry::correct(input, expected, remove_spike_threshold);
+	geometry::correct_inplace(actual, remove_spike_threshold);
+	equal = equal && to_string(expected) == to_string(actual);
+
+	if(equal)
+		std::cout << "In-place correct is equal to correct" << std::endl;
+	else
+		std::cout << "In-place correct is not equal to correct" << std::endl;
+}
+
+void compact_test()
+{
+	double nan = std::numeric_limits<double>::quiet_NaN();
+
+	// Square with invalid, repeated and collinear points
+	polygon poly;
+	poly.outer() = { { 0, 0 }, { nan, 1 }, { 0, 5 }, { 0, 10 }, { 0, 10 }, { nan, nan }, { 10, 10 }, { 10, 5 }, { 10, 0 }, { 5, nan }, { 5, 0 } };
+	for(std::size_t i = 0; i < 1000; ++i)
+		poly.outer().push_back( { nan, nan } );
+
+	geometry::corrector<point> corrector(1E-12);
+	corrector.set_remove_collinear(true);
+
+	multi_polygon result;
+	corrector.correct(poly, result);
+
+	if(result.size() == 1 && result.front().outer().size() == 5 && boost::geometry::area(result) == 100.0)
+		std::cout << "Invalid, repeated and collinear points are removed" << std::endl;
+	else
+		std::cout << "Invalid, repeated and collinear points are not removed" << std::endl;
+}
+
+void intersection_method_test()
+{
+	std::vector<std::string> cases = {
+		"POLYGON ((10 90, 90 10, 90 90, 10 10, 10 90))",
+		"POLYGON ((10 70, 90 70, 90 50, 30 50, 30 30, 50 30, 50 90, 70 90, 70 10, 10 10, 10 70))",
+		"POLYGON ((10 50, 80 50, 80 70, 40 70, 40 30, 30 30, 30 80, 90 80, 90 40, 20 40, 20 20, 50 20, 50 90, 60 90, 60 10, 10 10, 10 50))",
+		"POLYGON ((10 90, 90 90, 90 10, 60 10, 40 30, 70 60, 60 80, 40 60, 60 60, 40 80, 30 60, 60 30, 40 10, 10 10, 10 90))",
+		"POLYGON ((100 100, 100 300, 200 300, 200 130, 130 130, 130 250, 200 250, 200 160, 150 160, 150 220, 240 220, 240 160, 200 160, 200 250, 270 250, 270 130, 200 130, 200 300, 300 300, 300 100, 100 100))",
+		"POLYGON ((60 10, 10 10, 10 90, 90 90, 90 20, 20 20, 20 80, 80 80, 80 30, 30 30, 30 70, 70 70, 70 40, 40 40, 40 60, 60 60, 60 10))"
+	};
+
+	geometry::corrector<point> sweep(1E-12);
+	sweep.set_intersection_method(geometry::intersection_method::sweep);
+	geometry::corrector<point> self_turns(1E-12);
+	geometry::corrector<point> sections(1E-12);
+	sections.set_intersection_method(geometry::intersection_method::sections);
+
+	bool equal = true;
+	for(auto const &wkt: cases) {
+		polygon poly;
+		boost::geometry::read_wkt(wkt, poly);
+
+		multi_polygon sweep_result, self_turns_result, sections_result;
+		sweep.correct(poly, sweep_result);
+		self_turns.correct(poly, self_turns_result);
+		sections.correct(poly, sections_result);
+		equal = equal && std::abs(boost::geometry::area(sweep_result) - boost::geometry::area(self_turns_result)) < 1E-9;
+		equal = equal && boost::geometry::equals(sweep_result, sections_result);
+	}
+
+	if(equal)
+		std::cout << "Sweep intersections are equal to self turns and sections" << std::endl;
+	else
+		std::cout << "Sweep intersections are not equal to self turns and sections" << std::endl;
+}
+
+void random_intersection_method_test()
+{
+	std::mt19937_64 generator(7);
+	std::uniform_real_distribution<double> distribution(0.0, 1.0);
+
+	geometry::corrector<point> sweep(0.0);
+	sweep.set_intersection_method(geometry::intersection_method::sweep);
+	geometry::corrector<point> self_turns(0.0);
+	self_turns.set_intersection_method(geometry::intersection_method::self_turns);
+
+	auto differ = [&](polygon const &poly) {
+		multi_polygon sweep_result, self_turns_result;
+		sweep.correct(poly, sweep_result);
+		self_turns.correct(poly, self_turns_result);
+		return boost::geometry::is_valid(sweep_result) != boost::geometry::is_valid(self_turns_result) || 
+			std::abs(boost::geometry::area(sweep_result) - boost::geometry::area(self_turns_result)) > 1E-9;
+	};
+
+	// Random rings, and rings with the points on three random lines, some moved by an ulp
+	std::size_t random_differ = 0, collinear_differ = 0;
+	for(std::size_t run = 0; run < 200; ++run) {
+		polygon random, collinear;
+		std::size_t count = 5 + std::size_t(distribution(generator) * 25);
+		for(std::size_t i = 0; i < count; ++i)
+			random.outer().push_back( { distribution(generator), distribution(generator) } );
+		random.outer().push_back(random.outer().front());
+
+		double x[3], y[3], dx[3], dy[3];
+		for(std::size_t k = 0; k < 3; ++k) {
+			x[k] = distribution(generator); y[k] = distribution(generator);
+			dx[k] = distribution(generator) - 0.5; dy[k] = distribution(generator) - 0.5;
+		}
+		for(std::size_t i = 0; i < count; ++i) {
+			std::size_t k = std::size_t(distribution(generator) * 3);
+			double s = distribution(generator) * 2 - 1;
+			double px = x[k] + s * dx[k];
+			if(distribution(generator) < 0.3)
+				px = std::nextafter(px, distribution(generator) < 0.5 ? -2.0 : 2.0);
+			collinear.outer().push_back( { px, y[k] + s * dy[k] } );
+		}
+		collinear.outer().push_back(collinear.outer().front());
+
+		random_differ += differ(random);
+		collinear_differ += differ(collinear);
+	}
+
+	if(random_differ == 0)
+		std::cout << "Sweep intersections are equal to self turns on random rings" << std::endl;
+	else
+		std::cout << "Sweep intersections are not equal to self turns on " << random_differ << " of 200 random rings" << std::endl;
+	std::cout << "Sweep intersections differ from self turns on " << collinear_differ << " of 200 nearly collinear rings" << std::endl;
+}
+
+void near_vertex_test()
+{
+	std::mt19937_64 generator(1);
+	std::uniform_real_distribution<double> offset(0.05, 0.95), size(0.1, 1.0);
+
+	// Rings with a vertex b almost on the first edge c-d, where the ring crosses that edge. The 
+	// crossing is found at the end of the segment to b or at the start of the segment from b.
+	std::vector<polygon> polygons;
+	for(std::size_t run = 0; run < 200; ++run) {
+		double dx = size(generator), dy = size(generator), t = offset(generator);
+		point c(0, 0), d(dx, dy), b(t * dx, t * dy);
+		point a(b.x() - 0.3, b.y() + 0.5), e(b.x() + 0.3, b.y() - 0.5);
+
+		polygon poly;
+		poly.outer() = { c, d, point(dx, 2), a, b, e, point(0, -1), c };
+		boost::geometry::correct(poly);
+		polygons.push_back(poly);
+	}
+
+	bool valid = true;
+	for(auto method: { geometry::intersection_method::self_turns, geometry::intersection_method::sweep, geometry::intersection_method::sections }) {
+		geometry::corrector<point> corrector(0.0);
+		corrector.set_intersection_method(method);
+		for(auto const &poly: polygons) {
+			multi_polygon result;
+			corrector.correct(poly, result);
+			valid = valid && boost::geometry::is_valid(result) && result.size() == 2;
+		}
+	}
+
+	if(valid)
+		std::cout << "Crossings at a vertex near an edge are valid" << std::endl;
+	else
+		std::cout << "Crossings at a vertex near an edge are not valid" << std::endl;
+}
+
+void end_point_test()
+{
+	// Rings with a vertex on another edge, on the closing point of the ring, crossing the edge 
+	// or touching it. The intersection is at the end of one segment and the start of the next.
+	std::vector<std::pair<std::string, double>> cases = {
+		{ "POLYGON ((0 0, 10 10, 10 20, 2 7, 5 5, 8 3, 0 -10, 0 0))", 105.0 },
+		{ "POLYGON ((0 0, 10 10, 10 20, 2 7, 5 5, 2 3, 0 -10, 0 0))", 695.0 / 11.0 },
+		{ "POLYGON ((5 5, 10 0, 10 10, 0 10, 0 0, 5 5))", 75.0 },
+		{ "POLYGON ((0 5, 10 0, 10 10, 0 10, 0 0, 0 5))", 75.0 }
+	};
+
+	bool valid = true;
+	for(auto method: { geometry::intersection_method::self_turns, geometry::intersection_method::sweep, geometry::intersection_method::sections }) {
+		geometry::corrector<point> corrector(0.0);
+		corrector.set_intersection_method(method);
+		for(auto const &c: cases) {
+			polygon poly;
+			boost::geometry::read_wkt(c.first, poly);
+
+			multi_polygon result;
+			corrector.correct(poly, result);
+			valid = valid && boost::geometry::is_valid(result) && std::abs(boost::geometry::area(result) - c.second) < 1E-9;
+		}
+	}
+
+	if(valid)
+		std::cout << "Intersections at the end of a segment are valid" << std::endl;
+	else
+		std::cout << "Intersections at the end of a segment are not valid" << std::endl;
+}
+
+// Check if the ring continues straight on at one of its vertices
+bool has_collinear_vertices(multi_polygon const &geometry)
+{
+	auto collinear = [](bg::model::ring<point> const &ring) {
+		for(std::size_t i = 0; i + 1 < ring.size(); ++i) {
+			point const &a = ring[i == 0 ? ring.size() - 2 : i - 1], &b = ring[i], &c = ring[i + 1];
+			double side = (b.x() - a.x()) * (c.y() - b.y()) - (b.y() - a.y()) * (c.x() - b.x());
+			double dot = (b.x() - a.x()) * (c.x() - b.x()) + (b.y() - a.y()) * (c.y() - b.y());
+			if(side == 0 && dot > 0)
+				return true;
+		}
+		return false;
+	};
+
+	for(auto const &poly: geometry) {
+		if(collinear(poly.outer()))
+			return true;
+		for(auto const &inner: poly.inners()) {
+			if(collinear(inner))
+				return true;
+		}
+	}
+	return false;
+}
+
+void fill_method_test()
+{
+	// Area of the non-zero winding fill
+	std::vector<std::pair<std::string, double>> cases = {
+		{ "POLYGON ((10 70, 90 70, 90 50, 30 50, 30 30, 50 30, 50 90, 70 90, 70 10, 10 10, 10 70))", 4000.0 },
+		{ "POLYGON ((10 90, 90 90, 90 10, 60 10, 40 30, 70 60, 60 80, 40 60, 60 60, 40 80, 30 60, 60 30, 40 10, 10 10, 10 90))", 5500.0 },
+		{ "POLYGON ((0 100, 100 100, 100 0, 0 0, 0 100), (60 10, 60 60, 40 60, 40 40, 70 40, 70 70, 30 70, 30 30, 80 30, 80 80, 20 80, 20 20, 90 20, 90 90, 10 90, 10 10, 60 10))", 3900.0 },
+		{ "POLYGON ((10 90, 90 90, 90 10, 10 10, 10 90), (80 80, 80 30, 30 30, 30 80, 80 80), (20 20, 20 70, 70 70, 70 20, 20 20))", 3000.0 },
+		{ "POLYGON ((5 0, 10 0, 10 10, 0 10, 0 0, 5 0, 3 3, 5 6, 7 3, 5 0))", 88.0 }
+	};
+
+	geometry::corrector<point> direct(1E-12);
+	geometry::corrector<point> overlay(1E-12);
+	overlay.set_fill_method(geometry::fill_method::overlay);
+
+	bool direct_equal = true, overlay_equal = true, direct_collinear = false;
+	for(auto const &c: cases) {
+		polygon poly;
+		boost::geometry::read_wkt(c.first, poly);
+
+		multi_polygon direct_result, overlay_result;
+		direct.correct(poly, direct_result);
+		overlay.correct(poly, overlay_result);
+		direct_equal = direct_equal && boost::geometry::is_valid(direct_result) && std::abs(boost::geometry::area(direct_result) - c.second) < 1E-9;
+		overlay_equal = overlay_equal && std::abs(boost::geometry::area(overlay_result) - c.second) < 1E-9;
+		direct_collinear = direct_collinear || has_collinear_vertices(direct_result);
+	}
+
+	std::cout << "Direct fill is " << (direct_equal ? "" : "not ") << "equal to the winding area" << std::endl;
+	std::cout << "Overlay fill is " << (overlay_equal ? "" : "not ") << "equal to the winding area" << std::endl;
+	std::cout << "Direct fill " << (direct_collinear ? "keeps" : "removes") << " collinear vertices" << std::endl;
+}
+
+template<typename coordinate_t>
+bool coordinate_type_correct(std::string const &wkt, double area)
+{
+	typedef bg::model::d2::point_xy<coordinate_t> point_t;
+	typedef bg::model::polygon<point_t> polygon_t;
+	typedef bg::model::multi_polygon<polygon_t> multi_polygon_t;
+
+	polygon_t poly;
+	boost::geometry::read_wkt(wkt, poly);
+
+	multi_polygon_t result;
+	geometry::correct(poly, result);
+	return boost::geometry::is_valid(result) && std::abs(boost::geometry::area(result) - area) < 1E-2 * area;
+}
+
+void coordinate_type_test()
+{
+	// Pentagram, intersection points of the integer version are rounded to the grid
+	std::string const wkt = "POLYGON ((50 0, 25 90, 95 35, 5 35, 75 90, 50 0))";
+
+	polygon poly;
+	boost::geometry::read_wkt(wkt, poly);
+	multi_polygon result;
+	geometry::correct(poly, result);
+	double area = boost::geometry::area(result);
+
+	if(coordinate_type_correct<float>(wkt, area) && coordinate_type_correct<int>(wkt, area) && coordinate_type_correct<std::int64_t>(wkt, area))
+		std::cout << "Float and integer coordinates are corrected" << std::endl;
+	else
+		std::cout << "Float and integer coordinates are not corrected" << std::endl;
+}
+
+void integer_snap_test()
+{
+	typedef bg::model::d2::point_xy<int> point_t;
+	typedef bg::model::polygon<point_t> polygon_t;
+	typedef bg::model::multi_polygon<polygon_t> multi_polygon_t;
+
+	// Random rings on a coarse grid cross near many vertices and overlap after rounding
+	std::mt19937_64 generator(1);
+	std::uniform_int_distribution<int> coordinate(0, 100);
+	auto random_ring = [&generator, &coordinate](std::size_t size) {
+		bg::model::ring<point_t> ring;
+		for(std::size_t i = 0; i < size; ++i)
+			ring.push_back(point_t(coordinate(generator), coordinate(generator)));
+		ring.push_back(ring.front());
+		return ring;
+	};
+
+	bool valid = true;
+	for(std::size_t run = 0; run < 200; ++run) {
+		polygon_t poly;
+		poly.outer() = random_ring(20);
+		if(run % 2)
+			poly.inners().push_back(random_ring(10));
+
+		for(auto fill: { geometry::fill_method::direct, geometry::fill_method::overlay }) {
+			geometry::corrector<point_t> corrector(0.0);
+			corrector.set_fill_method(fill);
+			multi_polygon_t result;
+			corrector.correct(poly, result);
+			valid = valid && boost::geometry::is_valid(result);
+		}
+	}
+
+	std::cout << "Integer corrections are " << (valid ? "" : "not ") << "valid" << std::endl;
+}
+
+void statistics_test()
+{
+	polygon pentagram, holes;
+	boost::geometry::read_wkt("POLYGON ((5 0, 2.5 9, 9.5 3.5, 0.5 3.5, 7.5 9, 5 0))", pentagram);
+	boost::geometry::read_wkt("POLYGON ((10 90, 90 90, 90 10, 10 10, 10 90), (80 80, 80 30, 30 30, 30 80, 80 80), (20 20, 20 70, 70 70, 70 20, 20 20))", holes);
+
+	// The statistics do not change the result
+	geometry::correct_statistics statistics, odd_even_statistics;
+	bool equal = true;
+	for(auto const &poly: { pentagram, holes }) {
+		multi_polygon result, instrumented_result;
+		geometry::correct(poly, result, 1E-12);
+		geometry::correct(poly, instrumented_result, 1E-12, statistics);
+		equal = equal && boost::geometry::equals(result, instrumented_result);
+
+		multi_polygon odd_even_result;
+		geometry::correct_odd_even(poly, odd_even_result, 1E-12, odd_even_statistics);
+	}
+
+	// 5 intersections of the pentagram, the outer and both inners of the polygon with holes are corrected
+	if(equal && statistics.rings == 4 && statistics.turns == 5 && statistics.rings_traced > 0 && statistics.overlay_calls > 0 && odd_even_statistics.turns == 5)
+		std::cout << "Statistics are recorded" << std::endl;
+	else
+		std::cout << "Statistics are not recorded" << std::endl << statistics;
+}
+
+void wkb_test()
+{
+	// Round trip of a polygon with an inner
+	polygon poly;
+	boost::geometry::read_wkt("POLYGON((0 0, 0 10, 10 10, 10 0, 0 0), (2 2, 4 2, 4 4, 2 4, 2 2))", poly);
+	std::vector<unsigned char> wkb;
+	geometry::write_wkb(poly, wkb);
+	polygon read;
+	geometry::read_wkb(wkb.data(), wkb.size(), read);
+	bool round_trip = boost::geometry::equals(poly, read);
+
+	// Big endian EWKB triangle with SRID and z coordinates
+	std::vector<unsigned char> ewkb = { 0, 0xa0, 0, 0, 3, 0, 0, 0x10, 0xe6, 0, 0, 0, 1, 0, 0, 0, 4 };
+	for(double v: { 0.0, 0.0, 1.0, 0.0, 10.0, 1.0, 10.0, 0.0, 1.0, 0.0, 0.0, 1.0 }) {
+		unsigned char bytes[8];
+		std::memcpy(bytes, &v, 8);
+		for(int i = 7; i >= 0; --i)
+			ewkb.push_back(bytes[i]);
+	}
+	multi_polygon triangle;
+	geometry::read_wkb(ewkb.data(), ewkb.size(), triangle);
+	bool ewkb_read = triangle.size() == 1 && triangle.front().outer().size() == 4 && std::abs(boost::geometry::area(triangle)) == 50.0;
+
+	// Correction of the WKB pentagram equals the correction of the polygon
+	polygon pentagram;
+	boost::geometry::read_wkt("POLYGON ((5 0, 2.5 9, 9.5 3.5, 0.5 3.5, 7.5 9, 5 0))", pentagram);
+	multi_polygon expected, corrected;
+	geometry::correct(pentagram, expected, 1E-12);
+
+	wkb.clear();
+	geometry::write_wkb(pentagram, wkb);
+	std::vector<unsigned char> output;
+	geometry::correct_wkb(wkb.data(), wkb.size(), output, 1E-12);
+	geometry::read_wkb(output.data(), output.size(), corrected);
+	bool correct_equal = boost::geometry::equals(expected, corrected) && boost::geometry::is_valid(corrected);
+
+	// Truncated input
+	bool truncated_throws = false;
+	try {
+		geometry::read_wkb(wkb.data(), wkb.size() - 1, read);
+	} catch(geometry::read_wkb_exception const &) {
+		truncated_throws = true;
+	}
+
+	if(round_trip && ewkb_read && correct_equal && truncated_throws)
+		std::cout << "WKB is read, written and corrected" << std::endl;
+	else
+		std::cout << "WKB is not read, written and corrected" << std::endl;
+}
+
+void tiled_test()
+{
+	std::default_random_engine generator;
+	std::uniform_real_distribution<double> distribution(0.0,1.0);
+
+	// Random self intersecting polygons, corrected in tiles of about 32 vertices
+	bool equal = true;
+	for(std::size_t run = 0; run < 20; ++run) {
+		polygon poly;
+		for(std::size_t i = 0; i < 200; ++i) {
+			poly.outer().push_back( { distribution(generator), distribution(generator) } );
+		}
+		poly.outer().push_back( poly.outer().front() );
+
+		multi_polygon expected, result;
+		geometry::correct(poly, expected, 1E-12);
+		geometry::correct_tiled(poly, result, 1E-12, 32);
+		equal = equal && boost::geometry::is_valid(result) && std::abs(boost::geometry::area(expected) - boost::geometry::area(result)) < 1E-9;
+	}
+
+	// Tiles of the large polygon corrected on a thread pool
+	polygon large;
+	boost::geometry::read_wkt(wkt_CLC2006_180927, large);
+	multi_polygon expected, serial, parallel;
+	geometry::correct(large, expected, 0);
+	geometry::correct_tiled(large, serial, 0, 4096);
+	geometry::thread_pool pool(4);
+	geometry::correct_tiled(large, parallel, 0, 4096, pool);
+	equal = equal && std::abs(boost::geometry::area(expected) - boost::geometry::area(serial)) < 1E-9 * std::abs(boost::geometry::area(expected)) && boost::geometry::equals(serial, parallel);
+
+	if(equal)
+		std::cout << "Tiled correction equals the correction" << std::endl;
+	else
+		std::cout << "Tiled correction does not equal the correction" << std::endl;
+}
+
+void cache_test()
+{
+	std::default_random_engine generator;
+	std::uniform_real_distribution<double> distribution(0.0,1.0);
+
+	std::vector<polygon> polygons(10);
+	for(auto &poly: polygons) {
+		for(std::size_t i = 0; i < 20; ++i) {
+			poly.outer().push_back( { distribution(generator), distribution(generator) } );
+		}
+		poly.outer().push_back( poly.outer().front() );
+	}
+
+	// Results from the cache are the same as the correction, the second pass is taken from the cache
+	geometry::correct_cache cache(1 << 20);
+	bool equal = true;
+	for(std::size_t pass = 0; pass < 2; ++pass) {
+		for(auto const &poly: polygons) {
+			multi_polygon expected, result, expected_odd_even, result_odd_even;
+			geometry::correct(poly, expected, 1E-12);
+			cache.correct(poly, result, 1E-12);
+			geometry::correct_odd_even(poly, expected_odd_even, 1E-12);
+			cache.correct_odd_even(poly, result_odd_even, 1E-12);
+
+			std::vector<unsigned char> a, b;
+			geometry::write_wkb(expected, a);
+			geometry::write_wkb(expected_odd_even, a);
+			geometry::write_wkb(result, b);
+			geometry::write_wkb(result_odd_even, b);
+			equal = equal && a == b;
+		}
+	}
+	equal = equal && cache.hits() == 20 && cache.misses() == 20;
+
+	// Entries read back from the written cache
+	std::vector<unsigned char> data;
+	cache.write(data);
+	geometry::correct_cache restored(1 << 20);
+	restored.read(data.data(), data.size());
+	multi_polygon result;
+	restored.correct(polygons.front(), result, 1E-12);
+	equal = equal && restored.size() == 20 && restored.hits() == 1;
+
+	// Least recently used entries are removed from a small cache
+	geometry::correct_cache small(4096);
+	for(auto const &poly: polygons) {
+		multi_polygon output;
+		small.correct(poly, output, 1E-12);
+	}
+	equal = equal && small.bytes() <= 4096 && small.size() < polygons.size();
+
+	if(equal)
+		std::cout << "Cached correction equals the correction" << std::endl;
+	else
+		std::cout << "Cached correction does not equal the correction" << std::endl;
+}
+
 template<typename T = polygon>
 void correct_from_string(std::string const &input)
 {
@@ -214,15 +858,10 @@ void data_test_cases()
 	else	
 		std::cout << "Input is not valid" << std::endl;
 
-	auto start_time =std::chrono::high_resolution_clock::now();
-
 	multi_polygon result;
 	geometry::correct(poly, result, remove_spike_threshold);
 
-	auto stop_time = std::chrono::high_resolution_clock::now();
-
 	std::cout << "Result polygons:  " << result.size() << ", outer: " << result[0].outer().size() << ", inners: " << result[0].inners().size() << std::endl;
-	std::cout << std::chrono::duration_cast< std::chrono::milliseconds >(stop_time - start_time).count() << " ms " << std::endl;
 
 	std::string message;
 	if(boost::geometry::is_valid(result, message))
@@ -287,6 +926,22 @@ int main()
 	test_cases();
 	//data_test_cases();
 	random_test();
+	parallel_test();
+	batch_test();
+	fast_path_test();
+	inplace_test();
+	compact_test();
+	intersection_method_test();
+	random_intersection_method_test();
+	end_point_test();
+	near_vertex_test();
+	fill_method_test();
+	coordinate_type_test();
+	integer_snap_test();
+	statistics_test();
+	wkb_test();
+	tiled_test();
+	cache_test();
 	jts_test_cases(); 
 
 	// Reference cases from document